@@ -1,2 +1,3 @@
 mkdir target
-g++ -o target/hone src/hone.cpp -lcurl -I include
\ No newline at end of file
+g++ -o target/hone src/*.cpp -lcurl -lz -larchive -pthread -I include
+g++ -O2 -o target/vercmp_test tests/vercmp_test.cpp src/vercmp.cpp -I include && ./target/vercmp_test
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+
+
+// * Every package hone built, stored under a hash of the build's inputs.
+// * A build whose inputs hash the same as an earlier one skips makepkg and installs the stored
+// * packages, which turns reinstalls into a copy and an install.
+// *
+// * Each entry is a directory <hash>/ holding the packages and a MANIFEST of "version <version>"
+// * followed by "<sha256> <file name>" lines, plus the .sig of every package that makepkg signed.
+// * Served over HTTPS or shared as a directory,
+// * the cache doubles as a binary source for other machines (see Substituter).
+class Artifact_Cache {
+public:
+    explicit Artifact_Cache(const std::string &cache_dir);
+
+    // ? Hashes build_dir's PKGBUILD, .SRCINFO (and with it the source checksums), local source files,
+    // ? the makepkg configuration and architecture, and resolved_dependencies, which should hold the
+    // ? installed version of every build dependency. Empty when build_dir has no .SRCINFO, or when it has
+    // ? VCS or SKIP sources: their content is not part of any of these, so such builds are never cached
+    std::string Input_Hash(const std::string &build_dir, const std::vector<std::string> &resolved_dependencies) const;
+
+    // ? Paths of the stored packages, they stay in the cache and can be installed from there
+    bool Find(const std::string &input_hash, std::vector<std::string> &pkg_files) const;
+    bool Store(const std::string &input_hash, const std::string &version, const std::vector<std::string> &pkg_files) const;
+
+    const std::string &Directory() const { return cache_dir; }
+
+private:
+    const std::string cache_dir;
+};
@@ -0,0 +1,25 @@
+#pragma once
+#include <unordered_map>
+#include <string>
+#include <vector>
+
+
+// ? Subset of an AUR RPC package record that hone makes use of
+struct PKG_Info {
+    std::string name;
+    std::string package_base;
+    std::string version;
+    std::string description;
+    std::vector<std::string> depends;
+    std::vector<std::string> make_depends;
+    std::vector<std::string> check_depends;
+};
+
+using PKG_Info_Map = std::unordered_map<std::string, PKG_Info>;
+
+
+// ? Packs pkg_names into as few type=info URLs as the AUR URL length limit allows
+std::vector<std::string> Build_Info_URLs(const std::vector<std::string> &pkg_names);
+
+// ? Fetches the info records of pkg_names, returns false if any request failed
+bool Fetch_PKG_Infos(const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos);
@@ -0,0 +1,24 @@
+#pragma once
+#include <string>
+#include <vector>
+
+
+// * Runs every build in a transient cgroup v2 scope of the user's systemd instance.
+// * The scopes share one slice capped at the memory hone may use, so a build that outgrows
+// * its prediction is killed inside the slice instead of the OOM killer picking from the whole
+// * system. Each scope gets a lower CPU weight, which keeps the desktop responsive while building.
+// * Commands are left as they are when cgroup v2 or a user systemd instance is missing.
+class Build_Cgroups {
+public:
+    explicit Build_Cgroups(long memory_max_kb);
+
+    bool Is_Ready() const { return ready; }
+    // ? Prefixes args with systemd-run, the memory limit is the slice's, shared by every build
+    std::vector<std::string> Wrap(const std::vector<std::string> &args) const;
+
+private:
+    bool ready = false;
+};
+
+// ? MemAvailable of /proc/meminfo in KiB, 0 when it cannot be read
+long Available_Memory_KB();
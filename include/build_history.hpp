@@ -0,0 +1,39 @@
+#pragma once
+#include "process.hpp"
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <mutex>
+
+
+// * Wall time, CPU time and peak memory of every makepkg run, kept in an append-only text file.
+// * The latest runs of a package base estimate its next build, which the scheduler uses to start
+// * the longest chains first and to show an ETA.
+class Build_History {
+public:
+    explicit Build_History(const std::string &history_file);
+
+    // ? Only the first call reads the file
+    bool Load();
+    // ? Safe to call from build workers, the run is appended to the file right away
+    void Record(const std::string &package_base, const std::string &version, const Process_Usage &usage);
+
+    // ? Average wall time of the latest runs, 0 when the base was never built
+    double Wall_Seconds(const std::string &package_base) const;
+    // ? Largest peak resident set of the latest runs, 0 when the base was never built
+    long Peak_RSS_KB(const std::string &package_base) const;
+
+private:
+    struct Build_Run {
+        long long timestamp;
+        std::string version;
+        Process_Usage usage;
+    };
+
+    const std::string history_file;
+    mutable std::mutex history_mutex;
+    std::unordered_map<std::string, std::vector<Build_Run>> runs;
+    bool loaded = false;
+
+    void Compact();
+};
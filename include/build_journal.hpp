@@ -0,0 +1,47 @@
+#pragma once
+#include "resolver.hpp"
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <mutex>
+
+
+enum class Journal_State {
+    Planned,
+    Fetched,
+    Built,
+    Installed,
+    Failed
+};
+
+
+// * Progress of one update run, kept in a text file so a run that failed or got interrupted can go on
+// * where it stopped. The file starts with the targets and the whole build plan, then every fetch,
+// * build and install is appended as it happens. It is removed once the whole plan is installed.
+class Build_Journal {
+public:
+    explicit Build_Journal(const std::string &journal_file);
+
+    // ? Replaces any earlier journal
+    bool Begin(const std::vector<std::string> &targets, const Build_Plan &plan);
+    // ? Reads back the plan of an unfinished run and the last state of each of its bases
+    bool Load(std::vector<std::string> &targets, Build_Plan &plan);
+    void Finish();
+
+    // ? Safe to call from fetch and build threads, pkg_files belong to Built only
+    void Record(const std::string &package_base, Journal_State state, const std::vector<std::string> &pkg_files = {});
+
+    Journal_State State(const std::string &package_base) const;
+    // ? Package files of a Built base, false when it is not built or a file went missing since
+    bool Built_Files(const std::string &package_base, std::vector<std::string> &pkg_files) const;
+
+private:
+    struct Base_Progress {
+        Journal_State state = Journal_State::Planned;
+        std::vector<std::string> pkg_files;
+    };
+
+    const std::string journal_file;
+    mutable std::mutex journal_mutex;
+    std::unordered_map<std::string, Base_Progress> progress;
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include "resolver.hpp"
+#include <functional>
+#include <cstddef>
+
+
+// ? A finished build, and the package files it produced
+struct Built_Node {
+    const Build_Node *node;
+    std::vector<std::string> pkg_files;
+};
+
+// ? Downloads one package base and its sources, runs on a fetch thread
+using Fetch_Step = std::function<bool(const Build_Node &node)>;
+// ? Builds one package base and collects its package files, runs on a worker thread
+using Build_Step = std::function<bool(const Build_Node &node, std::vector<std::string> &pkg_files)>;
+// ? Installs a batch of finished builds in one transaction, runs on the scheduler's thread
+using Install_Step = std::function<bool(const std::vector<Built_Node> &built)>;
+// ? Expected build time of a base in seconds, 0 when nothing is known about it
+using Cost_Estimate = std::function<double(const Build_Node &node)>;
+// ? Expected peak memory of a build in KiB
+using Memory_Estimate = std::function<long(const Build_Node &node)>;
+
+
+// * Runs the builds of a plan concurrently, up to jobs at a time.
+// * A node only starts once every base it depends on was built and installed, so the wall time
+// * follows the longest chain of the plan rather than the sum of all builds.
+// *
+// * Nodes heading the longest remaining chain of estimated build time are fetched and started first,
+// * so a single long build is not left for last, and every start prints an ETA for the whole plan.
+// *
+// * Fetching is a stage of its own: up to fetch_jobs threads download the bases in that order
+// * while earlier ones build, so network and CPU time overlap instead of adding up.
+// *
+// * With a memory budget, a build is only admitted while the predicted peaks of all running builds
+// * still fit into it. Smaller ready builds may go ahead of one that has to wait.
+// *
+// * Installs are batched: finished dependencies are installed together once nothing else is ready
+// * to build, which gives one transaction per dependency layer, and everything no other node
+// * depends on is installed in a single final transaction after all builds succeeded.
+class Build_Scheduler {
+public:
+    Build_Scheduler(std::size_t jobs, std::size_t fetch_jobs, Fetch_Step fetch, Build_Step build, Install_Step install,
+        Cost_Estimate estimate = nullptr);
+
+    // ? One build is always admitted, so a plan cannot stall on a package larger than budget_kb
+    void Limit_Memory(long budget_kb, Memory_Estimate memory_estimate);
+
+    // ? A failed fetch or build only drops that base and whatever depends on it, the rest of the plan
+    // ? carries on. A failed install stops everything. True once every node is installed
+    bool Run(const Build_Plan &plan);
+
+private:
+    const std::size_t jobs;
+    const std::size_t fetch_jobs;
+    Fetch_Step fetch;
+    Build_Step build;
+    Install_Step install;
+    Cost_Estimate estimate;
+    long memory_budget_kb = 0;
+    Memory_Estimate memory_estimate;
+
+    // ? Estimated time from the start of each node until the end of the longest chain depending on it
+    std::vector<double> Chain_Costs(const std::vector<Build_Node> &nodes, const std::vector<std::vector<std::size_t>> &dependents,
+        std::vector<double> &costs) const;
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include "process.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// * Runs args (program first, looked up in PATH) inside working_dir, without a shell and without touching
+// * hone's own working directory, so it is safe to call from several threads at once.
+// * Output goes to log_file when one is given, environment adds "NAME=value" entries for the child.
+// * Returns the exit status of the command, 127 if it could not be started. usage, when given, receives
+// * the time and memory the command took. inherit_fds are close-on-exec descriptors the command alone keeps.
+int32_t Run_Command(const std::vector<std::string> &args, const std::string &working_dir = "", const std::string &log_file = "",
+    const std::vector<std::string> &environment = {}, Process_Usage *usage = nullptr, const std::vector<int> &inherit_fds = {});
+
+// ? Like Run_Command(), but collects standard output instead
+bool Read_Command(const std::vector<std::string> &args, const std::string &working_dir, std::string &output);
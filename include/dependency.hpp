@@ -0,0 +1,32 @@
+#pragma once
+#include <unordered_map>
+#include <string_view>
+#include <string>
+#include <vector>
+
+
+// ? A depends= or provides= entry such as glibc, python>=3.12 or libfoo.so=1-64
+struct Dependency {
+    std::string name;
+    std::string op;
+    std::string version;
+};
+
+Dependency Parse_Dependency(std::string_view text);
+
+// ? Whether something called name at version (empty for an unversioned provide) satisfies dep
+bool Satisfies(const Dependency &dep, std::string_view name, std::string_view version);
+
+
+// * Every package name and provide of a package set, for answering "is this dependency satisfied".
+class Provides_Map {
+public:
+    void Add(const std::string &pkg_name, const std::string &pkg_version, const std::vector<std::string> &provides);
+    void Clear() { providers.clear(); }
+
+    bool Satisfies(const Dependency &dep) const;
+
+private:
+    // ? Provided name, to the versions it is provided at
+    std::unordered_map<std::string, std::vector<std::string>> providers;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <zlib.h>
+#include <functional>
+#include <cstddef>
+#include <string>
+
+
+// ? Receives decoded bytes, returning false stops the stream
+using Gzip_Sink = std::function<bool(const char *data, std::size_t size)>;
+
+
+// * Push based gzip decoder for download callbacks. Servers may already have decoded the gzip layer,
+// * so the stream is only inflated when it starts with the gzip magic. The first two bytes are held
+// * back until both arrived, however the download happens to be chunked.
+class Gzip_Stream {
+public:
+    explicit Gzip_Stream(Gzip_Sink sink);
+    ~Gzip_Stream();
+
+    Gzip_Stream(const Gzip_Stream &) = delete;
+    Gzip_Stream &operator=(const Gzip_Stream &) = delete;
+
+    // ? False when the sink refused the data or the gzip stream is corrupt
+    bool Feed(const char *data, std::size_t size);
+    // ? Passes on a lone first byte when the whole stream was shorter than the magic
+    bool Finish();
+
+private:
+    Gzip_Sink sink;
+    z_stream stream{};
+    bool stream_ready = false;
+    bool checked_magic = false;
+    bool compressed = false;
+    std::string magic;
+
+    bool Forward(const char *data, std::size_t size);
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include "dependency.hpp"
+#include <unordered_map>
+#include <string>
+#include <vector>
+
+
+struct Installed_PKG {
+    std::string name;
+    std::string version;
+    std::vector<std::string> provides;
+    // ? Not provided by any sync repository, which for hone means it came from the AUR
+    bool foreign = false;
+};
+
+
+// * Every installed package, loaded once per run and shared by search, query, remove and update.
+class Installed_Store {
+public:
+    Installed_Store(const std::string &db_path, const std::string &cache_file);
+
+    // ? Only the first call does any work, later calls reuse what was loaded
+    bool Load();
+    // ? Forget the loaded set, so the next Load() sees packages installed or removed since
+    void Invalidate();
+
+    bool Contains(const std::string &pkg_name) const;
+    const Installed_PKG *Find(const std::string &pkg_name) const;
+    // ? Whether an installed package or provide satisfies dep
+    bool Satisfies(const Dependency &dep) const { return provides.Satisfies(dep); }
+    // ? Foreign packages sorted by name
+    std::vector<Installed_PKG> Foreign() const;
+
+private:
+    const std::string db_path;
+    const std::string cache_file;
+    std::unordered_map<std::string, Installed_PKG> pkgs;
+    Provides_Map provides;
+    bool loaded = false;
+};
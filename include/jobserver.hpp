@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+// * GNU make jobserver shared by every build hone runs at the same time.
+// * A fifo holds one token per slot beyond those of the clients, children find it through MAKEFLAGS:
+// * --jobserver-auth=fifo: for make 4.4 and later, or an inherited descriptor for older makes.
+// * cargo and ninja honour the same variable.
+// * Each client (every build running at the same time) also runs one job without a token, so all of
+// * them together never run more than slots jobs, instead of every build starting its own -j.
+class Jobserver {
+public:
+    // ? clients is how many builds may hold their implicit slot at once
+    Jobserver(std::size_t slots, std::size_t clients);
+    ~Jobserver();
+
+    Jobserver(const Jobserver &) = delete;
+    Jobserver &operator=(const Jobserver &) = delete;
+
+    bool Is_Ready() const { return fifo_fd >= 0; }
+    // ? "NAME=value" entries for Run_Command(), empty when the fifo could not be set up
+    std::vector<std::string> Environment() const;
+    // ? Descriptors the builds have to inherit for Environment() to work, pass them to Run_Command()
+    std::vector<int> Inherited_Fds() const;
+
+private:
+    const std::size_t slots;
+    std::string fifo_path;
+    // ? Held open for reading and writing, so the tokens survive while no build has the fifo open
+    int fifo_fd = -1;
+    // ? For makes that only know the descriptor form, -1 when they understand fifo:. It is close-on-exec
+    // ? like every other descriptor of hone, only the builds get it through Inherited_Fds()
+    int inherited_fd = -1;
+};
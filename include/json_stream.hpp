@@ -0,0 +1,78 @@
+#pragma once
+#include "aur_rpc.hpp"
+#include <nlohmann/json.hpp>
+#include <functional>
+#include <cstdint>
+#include <string>
+
+using PKG_Info_Callback = std::function<void(PKG_Info &&info)>;
+
+
+// * SAX handler turning package objects into PKG_Info records without building a DOM.
+// * record_depth is the nesting level of the package objects, 1 for a lone object, 2 for the objects of an array.
+class PKG_Info_SAX : public nlohmann::json::json_sax_t {
+public:
+    PKG_Info_SAX(int32_t record_depth, PKG_Info_Callback on_record);
+
+    bool null() override { return Value(""); }
+    bool boolean(bool) override { return Value(""); }
+    bool number_integer(number_integer_t) override { return Value(""); }
+    bool number_unsigned(number_unsigned_t) override { return Value(""); }
+    bool number_float(number_float_t, const string_t &) override { return Value(""); }
+    bool string(string_t &value) override { return Value(value); }
+    bool binary(binary_t &) override { return Value(""); }
+
+    bool start_object(std::size_t) override;
+    bool end_object() override;
+    bool start_array(std::size_t) override;
+    bool end_array() override;
+    bool key(string_t &value) override;
+    bool parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &error) override;
+
+    const std::string &Error() const { return error; }
+
+private:
+    const int32_t record_depth;
+    PKG_Info_Callback on_record;
+    PKG_Info current;
+    std::string current_key;
+    std::string error;
+    int32_t depth = 0;
+
+    bool Value(const std::string &value);
+    std::vector<std::string> *List(const std::string &key);
+};
+
+
+// * Push parser for AUR RPC replies, fed straight from a curl write callback.
+// * Each element of "results" is handed to on_result as soon as its closing brace arrives,
+// * so only one result is ever buffered no matter how many the reply holds.
+class Result_Stream {
+public:
+    explicit Result_Stream(PKG_Info_Callback on_result);
+
+    // ? Returns false once the input stops being valid JSON
+    bool Feed(const char *data, std::size_t size);
+
+    // ? True when a whole reply was consumed and it was not an RPC error
+    bool Is_Complete() const { return valid && seen_document && depth == 0 && error.empty(); }
+    const std::string &Error() const { return error; }
+
+private:
+    PKG_Info_SAX result_parser;
+    std::string result_buffer;
+    std::string top_level_string;
+    std::string last_key;
+    std::string error;
+    int32_t depth = 0;
+    bool in_string = false;
+    bool escaped = false;
+    bool expect_key = false;
+    bool in_results = false;
+    bool capturing = false;
+    bool seen_document = false;
+    bool valid = true;
+
+    void On_Top_Level_String();
+    bool Emit_Result();
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include "installed_store.hpp"
+#include <unordered_set>
+#include <string_view>
+#include <string>
+#include <vector>
+
+
+// ? Value of a %FIELD% section of a pacman desc file, as a view into desc
+std::string_view Desc_Field(std::string_view desc, std::string_view field);
+// ? Every line of a multi line %FIELD% section
+std::vector<std::string> Desc_List(std::string_view desc, std::string_view field);
+// ? Paths of every sync database under db_path, sorted
+std::vector<std::string> Sync_DBs(const std::string &db_path);
+
+
+// * Native reader for the pacman database under db_path (normally /var/lib/pacman/).
+// * local/*/desc is read in parallel, foreign packages are found by checking the sync databases,
+// * and the result is cached in cache_file until any of those directories or databases change.
+class Local_DB {
+public:
+    Local_DB(const std::string &db_path, const std::string &cache_file);
+
+    bool Read(std::vector<Installed_PKG> &pkgs);
+
+private:
+    const std::string db_path;
+    const std::string cache_file;
+
+    // ? Modification times of everything the result depends on, the cache is valid while it matches
+    std::string Signature() const;
+    bool Read_Cache(const std::string &signature, std::vector<Installed_PKG> &pkgs) const;
+    void Write_Cache(const std::string &signature, const std::vector<Installed_PKG> &pkgs) const;
+
+    bool Read_Local(std::vector<Installed_PKG> &pkgs) const;
+    bool Read_Sync_Names(std::unordered_set<std::string> &sync_names) const;
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include "package_index.hpp"
+#include "aur_rpc.hpp"
+#include <string>
+#include <vector>
+#include <ctime>
+
+
+// * Local copy of the AUR metadata dump (packages-meta-ext-v1.json.gz).
+// * Refresh() downloads the dump and rebuilds the on-disk index, Load() maps that index,
+// * after which search and info lookups are answered without touching the network.
+class Metadata_Snapshot {
+public:
+    explicit Metadata_Snapshot(const std::string &cache_dir);
+
+    bool Refresh();
+    bool Load();
+
+    bool Is_Loaded() const { return index.Is_Open(); }
+    std::time_t Last_Refresh() const;
+
+    // ? Packages whose name contains query, case insensitive
+    std::vector<PKG_Info> Search(const std::string &query) const;
+    bool Find(const std::string &pkg_name, PKG_Info &info) const;
+
+private:
+    const std::string cache_dir;
+    const std::string index_path;
+    Package_Index index;
+    bool load_failed = false;
+
+    bool Download_Dump(const std::string &dump_path);
+    bool Build_Index(const std::string &dump_path);
+};
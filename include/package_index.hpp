@@ -0,0 +1,112 @@
+#pragma once
+#include "aur_rpc.hpp"
+#include <string_view>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// * On-disk layout of the package index, in native byte order since it never leaves the machine.
+// *
+// * Index_Header                                  magic, format version and section count
+// * Section_Header[section_count]                 where each section lives in the file
+// * RECORDS   Index_Record[]                      one fixed-width record per package, sorted by name
+// * NAMES     char[]                              every name in record order, each ending in '\0'
+// * OFFSETS   uint32_t[]                          where each record's name starts in NAMES
+// * LISTS     String_Ref[]                        dependency lists the records point into
+// * STRINGS   char[]                              every other string the records and lists point into
+// *
+// * Names sit apart from everything else, so a search scans NAMES alone and a lookup by name
+// * binary searches OFFSETS and NAMES, neither pages in records or strings until a package matches.
+namespace Index_Format {
+    constexpr char MAGIC[8] = { 'H', 'O', 'N', 'E', 'I', 'D', 'X', '\0' };
+    constexpr uint32_t VERSION = 3;
+
+    enum Section_ID : uint32_t {
+        RECORDS = 1,
+        NAMES = 2,
+        STRINGS = 3,
+        LISTS = 4,
+        OFFSETS = 5,
+    };
+
+    struct Index_Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t section_count;
+    };
+
+    struct Section_Header {
+        uint32_t id;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct String_Ref {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    // ? count String_Refs starting at LISTS[offset]
+    struct List_Ref {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    struct Index_Record {
+        String_Ref package_base;
+        String_Ref version;
+        String_Ref description;
+        List_Ref depends;
+        List_Ref make_depends;
+        List_Ref check_depends;
+    };
+}
+
+
+// ? Writes pkgs to path as a fresh index, pkgs does not need to be sorted
+bool Write_Package_Index(const std::string &path, const std::vector<PKG_Info> &pkgs);
+
+
+// * Read-only view of an index file.
+// * Open() costs one open and one mmap, records are only paged in once something reads them.
+class Package_Index {
+public:
+    Package_Index() = default;
+    ~Package_Index();
+
+    Package_Index(const Package_Index &) = delete;
+    Package_Index &operator=(const Package_Index &) = delete;
+
+    bool Open(const std::string &path);
+    void Close();
+
+    bool Is_Open() const { return data != nullptr; }
+    std::size_t Size() const { return record_count; }
+
+    std::string_view Name(std::size_t index) const;
+    // ? The NAMES section: every name in record order, each ending in '\0'
+    std::string_view Names() const { return { names, names_size }; }
+    PKG_Info Info(std::size_t index) const;
+
+    // ? Index of the record called pkg_name, or Size() if there is none
+    std::size_t Find(std::string_view pkg_name) const;
+
+private:
+    const char *data = nullptr;
+    std::size_t data_size = 0;
+
+    const Index_Format::Index_Record *records = nullptr;
+    const char *names = nullptr;
+    const uint32_t *name_offsets = nullptr;
+    const Index_Format::String_Ref *lists = nullptr;
+    const char *strings = nullptr;
+    std::size_t record_count = 0;
+    std::size_t names_size = 0;
+    std::size_t list_size = 0;
+    std::size_t strings_size = 0;
+
+    std::string_view String(const Index_Format::String_Ref &ref) const;
+    std::vector<std::string> List(const Index_Format::List_Ref &ref) const;
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include <sys/types.h>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+
+struct Process_Options {
+    // ? Program and arguments, the program is looked up in PATH
+    std::vector<std::string> args;
+    // ? The child starts here, hone's own working directory is never touched
+    std::string working_dir;
+    // ? "NAME=value" entries added to, or replacing, what the child inherits from hone
+    std::vector<std::string> environment;
+    // ? Standard output and error go to this file and standard input is /dev/null,
+    // ? otherwise the child shares hone's terminal
+    std::string log_file;
+    // ? Standard output is read through a pipe and handed to the output callback
+    bool capture_output = false;
+    // ? Samples the summed resident set of the child and all of its descendants while it runs
+    bool sample_memory = false;
+    // ? Close-on-exec descriptors of hone that this child alone keeps open under the same number
+    std::vector<int> inherit_fds;
+};
+
+// ? Resources a child and the descendants it waited for used
+struct Process_Usage {
+    double wall_seconds = 0;
+    double cpu_seconds = 0;
+    // ? Peak of the summed resident set of the whole tree with Process_Options::sample_memory,
+    // ? otherwise of the largest single process in it
+    long peak_rss_kb = 0;
+};
+
+// ? Receives a chunk of a child's standard output
+using Output_Callback = std::function<void(const char *data, std::size_t size)>;
+// ? Called once the child exited and its output was read to the end, with the exit status
+// ? (128 + signal number when it was killed)
+using Exit_Callback = std::function<void(int32_t exit_code, const Process_Usage &usage)>;
+
+
+// * A set of child processes started with posix_spawn and waited for together.
+// * Wait() runs an epoll loop over a pidfd per child and their output pipes, so any number of children
+// * are watched by one thread. Groups share nothing, each thread can drive its own: Run_Command() and
+// * Read_Command() use a one-child group per call, so every build scheduler thread waits on its own child.
+class Process_Group {
+public:
+    Process_Group();
+    // ? Waits for the children that are still running
+    ~Process_Group();
+
+    Process_Group(const Process_Group &) = delete;
+    Process_Group &operator=(const Process_Group &) = delete;
+
+    // ? Returns false if the program could not be started, on_exit is not called then
+    bool Spawn(const Process_Options &options, Exit_Callback on_exit, Output_Callback on_output = nullptr);
+
+    // ? Dispatches output and exits until every child is done
+    void Wait();
+
+private:
+    struct Child {
+        pid_t pid = -1;
+        int pidfd = -1;
+        int output_fd = -1;
+        bool exited = false;
+        int32_t exit_code = 0;
+        std::chrono::steady_clock::time_point start_time;
+        bool sample_memory = false;
+        Process_Usage usage;
+        Exit_Callback on_exit;
+        Output_Callback on_output;
+    };
+
+    int epoll_fd = -1;
+    std::vector<std::unique_ptr<Child>> children;
+    std::size_t running = 0;
+    // ? Children without a pidfd (kernels before 5.3) are polled with waitpid instead
+    bool needs_polling = false;
+
+    void Sample_Memory();
+    void Read_Output(Child &child);
+    void Reap(Child &child, bool block);
+    void Finish_If_Done(Child &child);
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include "installed_store.hpp"
+#include "sync_db.hpp"
+#include "aur_rpc.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+
+// ? One AUR package base to clone and build
+struct Build_Node {
+    std::string package_base;
+    std::string version;
+    // ? Packages of this base that are needed, split package bases build more than these
+    std::vector<std::string> pkg_names;
+    // ? Package bases that have to be built and installed before this one
+    std::vector<std::string> dependencies;
+    // ? Only pulled in to satisfy another package, so it gets installed --asdeps
+    bool is_dependency = true;
+};
+
+struct Build_Plan {
+    // ? Topologically sorted, every node comes after all of its dependencies
+    std::vector<Build_Node> nodes;
+    // ? Dependencies pacman installs from the sync repositories
+    std::vector<std::string> repo_depends;
+    // ? Repository packages only needed while building, they can be removed again afterwards
+    std::vector<std::string> repo_make_depends;
+    // ? Dependencies found nowhere
+    std::vector<std::string> missing;
+};
+
+// ? Fills the map with the AUR records of the given names, like Fetch_PKG_Infos()
+using Info_Source = std::function<bool(const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos)>;
+
+
+// * Expands targets into every AUR package base they need, level by level.
+// * Each dependency is satisfied by an installed package first, then by the sync repositories,
+// * and only then by the AUR; all unknown names of one level are fetched in a single batch.
+class Dependency_Resolver {
+public:
+    Dependency_Resolver(const Installed_Store &installed, const Sync_DB &sync_db, Info_Source fetch_infos);
+
+    // ? False if something is missing, the AUR could not be reached, or the dependencies form a cycle
+    bool Resolve(const std::vector<std::string> &targets, Build_Plan &plan);
+
+private:
+    const Installed_Store &installed;
+    const Sync_DB &sync_db;
+    Info_Source fetch_infos;
+
+    bool Sort_Nodes(std::unordered_map<std::string, Build_Node> &nodes, Build_Plan &plan);
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <curl/curl.h>
+#include <functional>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+
+
+// ? Receives a chunk of the response body, returning false aborts the transfer
+using Data_Callback = std::function<bool(const char *data, std::size_t size)>;
+// ? Called once per request, with success set only for a completed 2xx/3xx response
+using Done_Callback = std::function<void(bool success, long status)>;
+
+
+// * HTTP client on top of curl_multi.
+// * Keeps its connections alive between requests, multiplexes them over HTTP/2 where the server allows it,
+// * and never runs more than max_in_flight transfers at once.
+class RPC_Client {
+public:
+    explicit RPC_Client(const std::string &base_url, std::size_t max_in_flight = 8);
+    ~RPC_Client();
+
+    RPC_Client(const RPC_Client &) = delete;
+    RPC_Client &operator=(const RPC_Client &) = delete;
+
+    // ? Requests may be queued from inside callbacks, they are picked up by the running Perform()
+    void Queue(const std::string &url, Data_Callback on_data, Done_Callback on_done = nullptr);
+
+    // ? Drives every queued request to completion, returns false if any of them failed
+    bool Perform();
+
+    // ? Blocking GET of a single url into body
+    bool Get(const std::string &url, std::string &body);
+
+    std::string Escape(const std::string &text);
+    const std::string &Base_URL() const { return base_url; }
+
+private:
+    struct Request {
+        std::string url;
+        Data_Callback on_data;
+        Done_Callback on_done;
+    };
+
+    const std::string base_url;
+    const std::size_t max_in_flight;
+    CURLM *multi = nullptr;
+    std::deque<Request> pending;
+    std::vector<CURL*> idle_handles;
+    std::size_t in_flight = 0;
+
+    static std::size_t Write_Callback(void *contents, std::size_t size, std::size_t nmemb, void *userp);
+    void Start_Pending();
+    bool Finish(CURL *easy, CURLcode result);
+};
+
+
+// ? Process-wide client for the AUR, HONE_AUR_URL overrides the host (e.g. a local mock server)
+RPC_Client &AUR_Client();
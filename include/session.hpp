@@ -0,0 +1,35 @@
+#pragma once
+#include "resolver.hpp"
+#include <unordered_set>
+#include <optional>
+#include <string>
+#include <vector>
+
+
+// * State shared by everything one hone invocation does, so no question is asked twice.
+// * AUR records are remembered for the whole run (missing packages included), while the pending
+// * updates and the last resolved plan are dropped whenever the installed set changes.
+class Session {
+public:
+    explicit Session(Info_Source fetch_infos);
+
+    // ? Answers known names from memory and fetches the rest in a single batch
+    bool PKG_Infos(const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos);
+
+    // ? Outdated foreign packages, once Check_For_Updates() filled them in
+    std::optional<std::vector<std::string>> updates;
+
+    // ? Returns the plan resolved earlier for the same targets, if the installed set did not change since
+    const Build_Plan *Plan_For(const std::vector<std::string> &targets) const;
+    void Remember_Plan(const std::vector<std::string> &targets, const Build_Plan &plan);
+
+    // ? Call after packages got installed or removed
+    void Installed_Changed();
+
+private:
+    Info_Source fetch_infos;
+    PKG_Info_Map known_infos;
+    std::unordered_set<std::string> unknown_names;
+    std::vector<std::string> plan_targets;
+    std::optional<Build_Plan> plan;
+};
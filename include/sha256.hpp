@@ -0,0 +1,28 @@
+#pragma once
+#include <string_view>
+#include <cstdint>
+#include <string>
+
+
+// * Incremental SHA-256 (FIPS 180-4), used to key cached build artifacts by their inputs.
+class SHA256 {
+public:
+    SHA256();
+
+    void Update(const void *data, std::size_t size);
+    void Update(std::string_view text) { Update(text.data(), text.size()); }
+    // ? Lower case hex digest, the hasher can not be updated afterwards
+    std::string Hex_Digest();
+
+private:
+    std::uint32_t state[8];
+    std::uint8_t block[64];
+    std::size_t block_size = 0;
+    std::uint64_t total_size = 0;
+
+    void Transform(const std::uint8_t *data);
+};
+
+
+// ? Digest of a whole file, empty if it can not be read
+std::string SHA256_File(const std::string &path);
@@ -0,0 +1,32 @@
+#pragma once
+#include "srcinfo.hpp"
+#include <cstdint>
+#include <string>
+
+
+// ? Hard link when possible, then a reflink, then a plain copy. The copy goes through a temporary
+// ? name, so a reader never sees a partial file under the final one
+bool Link_File(const std::string &from, const std::string &to);
+
+
+// * Shared download cache for package sources, stored by checksum under cache_dir.
+// * Cached files are hard linked (or reflinked, or copied across filesystems) into a build directory
+// * before makepkg looks for its sources, so a rebuild or pkgrel bump finds them already there,
+// * and packages sharing a tarball download it once. Entries are evicted least recently used first.
+class Source_Cache {
+public:
+    Source_Cache(const std::string &cache_dir, std::uintmax_t max_size);
+
+    // ? Places every cached source of build_dir's .SRCINFO next to its PKGBUILD, returns how many
+    std::size_t Materialize(const std::string &build_dir) const;
+    // ? Adds the sources makepkg downloaded into build_dir, only call it after makepkg verified them
+    std::size_t Store(const std::string &build_dir) const;
+    // ? Removes the least recently used entries until the cache fits max_size again
+    void Evict() const;
+
+private:
+    const std::string cache_dir;
+    const std::uintmax_t max_size;
+
+    std::string Entry_Path(const Source_Entry &source) const;
+};
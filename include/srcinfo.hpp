@@ -0,0 +1,34 @@
+#pragma once
+#include <unordered_map>
+#include <string>
+#include <vector>
+
+
+// ? Every "key = value" of a .SRCINFO, repeated keys keep their order
+using Srcinfo = std::unordered_map<std::string, std::vector<std::string>>;
+
+// ? A source with a checksum strong enough to identify its content by
+struct Source_Entry {
+    std::string file_name;
+    std::string url;
+    // ? makepkg's name for the algorithm, like sha256 or b2
+    std::string algorithm;
+    std::string checksum;
+};
+
+
+// ? Only the pkgbase section is read, package sections can not change sources or checksums
+bool Read_Srcinfo(const std::string &path, Srcinfo &fields);
+
+// ? Downloaded sources (not VCS or files in the package repository) with a SHA-2 or BLAKE2 checksum,
+// ? weaker or skipped checksums can not stand in for the content
+std::vector<Source_Entry> Checksummed_Sources(const Srcinfo &fields);
+
+// ? VCS sources (git+https://..., svn://...) and sources with a SKIP checksum, whose content can change
+// ? upstream without the PKGBUILD or .SRCINFO changing
+bool Has_Unpinned_Sources(const Srcinfo &fields);
+
+// ? depends, makedepends and checkdepends, including their architecture specific variants
+std::vector<std::string> Build_Dependencies(const Srcinfo &fields);
+// ? Sources shipped in the package repository itself, along with the install and changelog files
+std::vector<std::string> Local_Files(const Srcinfo &fields);
@@ -0,0 +1,33 @@
+#pragma once
+#include "artifact_cache.hpp"
+#include <atomic>
+#include <string>
+#include <vector>
+
+
+// * Looks up prebuilt packages in other machines' artifact caches before any source gets downloaded.
+// * A source is a directory or an http(s) url laid out like Artifact_Cache: <hash>/MANIFEST next to
+// * the packages it lists. The MANIFEST comes from the same place as the packages, so its version and
+// * SHA-256 lines only catch broken transfers. What makes a substitute trusted is the detached .sig of
+// * every package, checked by pacman-key against the pacman keyring: the builder has to sign with
+// * makepkg --sign, and its key has to be locally signed on this machine. That check does not depend
+// * on the transport, so a plain http mirror on the local network is as safe as an https one.
+// * Taken substitutes are imported into the local artifact cache, signatures included.
+class Substituter {
+public:
+    Substituter(const std::vector<std::string> &sources, const Artifact_Cache &artifact_cache);
+
+    bool Has_Sources() const { return !sources.empty(); }
+
+    // ? Tries the sources in order, on success pkg_files point into the local artifact cache
+    bool Fetch(const std::string &input_hash, const std::string &version, std::vector<std::string> &pkg_files);
+
+    std::size_t Hits() const { return hits; }
+
+private:
+    const std::vector<std::string> sources;
+    const Artifact_Cache &artifact_cache;
+    std::atomic<std::size_t> hits{ 0 };
+
+    bool Fetch_From(const std::string &source, const std::string &input_hash, const std::string &version, const std::string &tmp_path);
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include "dependency.hpp"
+#include <string>
+
+
+// * Names, versions and provides of everything in the sync databases under db_path,
+// * used to tell dependencies that pacman can install from the ones that have to come from the AUR.
+class Sync_DB {
+public:
+    explicit Sync_DB(const std::string &db_path);
+
+    // ? Only the first call reads the databases
+    bool Load();
+    bool Satisfies(const Dependency &dep) const { return provides.Satisfies(dep); }
+
+private:
+    const std::string db_path;
+    Provides_Map provides;
+    bool loaded = false;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include "gzip_stream.hpp"
+#include <cstdint>
+#include <string>
+
+struct archive;
+
+
+// * Push based extractor for .tar.gz archives, fed straight from a download callback.
+// * Gzip is inflated as the bytes arrive, tar headers (ustar, pax and GNU long names) are parsed here,
+// * and the entries are written under dest_dir by libarchive's disk writer, which also refuses
+// * paths leaving dest_dir.
+class Tar_Stream {
+public:
+    // ? strip_components leading path components are dropped, like tar --strip-components
+    Tar_Stream(const std::string &dest_dir, std::size_t strip_components = 1);
+    ~Tar_Stream();
+
+    Tar_Stream(const Tar_Stream &) = delete;
+    Tar_Stream &operator=(const Tar_Stream &) = delete;
+
+    // ? Returns false once the input stops being a valid archive, or an entry can not be written
+    bool Feed(const char *data, std::size_t size);
+
+    // ? True when the end of the archive was reached without errors
+    bool Is_Complete() const { return error.empty() && state == State::END; }
+    const std::string &Error() const { return error; }
+
+private:
+    enum class State { HEADER, DATA, PADDING, END };
+
+    const std::string dest_dir;
+    const std::size_t strip_components;
+    Gzip_Stream gzip;
+    archive *disk = nullptr;
+
+    State state = State::HEADER;
+    std::string header;
+    std::uint64_t remaining = 0;
+    std::uint64_t padding = 0;
+    char entry_type = 0;
+    bool entry_open = false;
+    std::string entry_data;
+    // ? Set by pax and GNU long name entries, they apply to the next header only
+    std::string next_path;
+    std::string next_link;
+    std::string error;
+
+    bool Feed_Tar(const char *data, std::size_t size);
+    bool Start_Entry();
+    bool Finish_Entry();
+    bool Fail(const std::string &message);
+};
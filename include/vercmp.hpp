@@ -0,0 +1,21 @@
+#pragma once
+#include <string_view>
+#include <cstdint>
+
+
+// * A version split into [epoch:]pkgver[-pkgrel], as views into the original string.
+// * Splitting once up front lets hot loops compare without allocating or rescanning for separators.
+struct PKG_Version {
+    std::string_view epoch;
+    std::string_view pkgver;
+    std::string_view pkgrel;
+    bool has_pkgrel = false;
+};
+
+
+// ? full must outlive the returned views
+PKG_Version Parse_Version(std::string_view full);
+
+// ? Same ordering as pacman's vercmp: negative if a is older than b, 0 if equal, positive if newer
+int32_t Compare_Versions(const PKG_Version &a, const PKG_Version &b);
+int32_t Vercmp(std::string_view a, std::string_view b);
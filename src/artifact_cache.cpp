@@ -0,0 +1,122 @@
+#include "../include/artifact_cache.hpp"
+#include "../include/source_cache.hpp"
+#include "../include/srcinfo.hpp"
+#include "../include/sha256.hpp"
+#include <sys/utsname.h>
+#include <filesystem>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+// ? Bumped whenever the hashed inputs change, so old entries are never matched by mistake
+static const std::string HASH_VERSION = "hone-artifact 2";
+static const std::string MANIFEST_FILE = "MANIFEST";
+
+
+// ? Every makepkg.conf makepkg reads, they decide flags like CFLAGS and the package compression.
+// ? Each comes with a label that is the same on every machine, home directories differ between users
+static std::vector<std::pair<std::string, std::string>> Makepkg_Configs()
+{
+    std::vector<std::pair<std::string, std::string>> configs = { { "/etc/makepkg.conf", "/etc/makepkg.conf" } };
+    std::vector<std::pair<std::string, std::string>> drop_ins;
+    std::error_code error;
+    for (const auto &file : std::filesystem::directory_iterator("/etc/makepkg.conf.d", error)) {
+        if (file.path().extension() == ".conf") drop_ins.push_back({ "conf.d/" + file.path().filename().string(), file.path().string() });
+    }
+    std::sort(drop_ins.begin(), drop_ins.end());
+    configs.insert(configs.end(), drop_ins.begin(), drop_ins.end());
+
+    if (const char *home = std::getenv("HOME")) {
+        configs.push_back({ "~/.makepkg.conf", std::string(home) + "/.makepkg.conf" });
+        configs.push_back({ "~/.config/pacman/makepkg.conf", std::string(home) + "/.config/pacman/makepkg.conf" });
+    }
+    return configs;
+}
+
+
+Artifact_Cache::Artifact_Cache(const std::string &cache_dir)
+    : cache_dir(cache_dir)
+{
+}
+
+
+std::string Artifact_Cache::Input_Hash(const std::string &build_dir, const std::vector<std::string> &resolved_dependencies) const
+{
+    Srcinfo fields;
+    if (!Read_Srcinfo(build_dir + "/.SRCINFO", fields) || Has_Unpinned_Sources(fields)) return "";
+
+    SHA256 hasher;
+    hasher.Update(HASH_VERSION + '\n');
+
+    struct utsname machine;
+    if (uname(&machine) == 0) hasher.Update(std::string("arch ") + machine.machine + '\n');
+
+    for (const auto &[label, path] : Makepkg_Configs()) {
+        if (std::filesystem::exists(path)) hasher.Update("config " + label + " " + SHA256_File(path) + '\n');
+    }
+
+    hasher.Update("PKGBUILD " + SHA256_File(build_dir + "/PKGBUILD") + '\n');
+    hasher.Update(".SRCINFO " + SHA256_File(build_dir + "/.SRCINFO") + '\n');
+
+    std::vector<std::string> local_files = Local_Files(fields);
+    std::sort(local_files.begin(), local_files.end());
+    for (const auto &file : local_files) hasher.Update("file " + file + " " + SHA256_File(build_dir + "/" + file) + '\n');
+
+    std::vector<std::string> dependencies = resolved_dependencies;
+    std::sort(dependencies.begin(), dependencies.end());
+    for (const auto &dependency : dependencies) hasher.Update("depends " + dependency + '\n');
+
+    return hasher.Hex_Digest();
+}
+
+
+bool Artifact_Cache::Find(const std::string &input_hash, std::vector<std::string> &pkg_files) const
+{
+    pkg_files.clear();
+    std::error_code error;
+    for (const auto &file : std::filesystem::directory_iterator(cache_dir + input_hash, error)) {
+        const std::string file_name = file.path().filename().string();
+        if (!file.is_regular_file(error) || file_name.find(".pkg.tar") == std::string::npos || file.path().extension() == ".sig") continue;
+        pkg_files.push_back(file.path().string());
+    }
+    std::sort(pkg_files.begin(), pkg_files.end());
+    return !pkg_files.empty();
+}
+
+
+bool Artifact_Cache::Store(const std::string &input_hash, const std::string &version, const std::vector<std::string> &pkg_files) const
+{
+    // ? Filled under a temporary name and renamed, so Find() never sees half an entry
+    const std::string entry_path = cache_dir + input_hash;
+    const std::string tmp_path = entry_path + ".tmp" + std::to_string(getpid());
+    std::error_code error;
+    std::filesystem::remove_all(tmp_path, error);
+    std::filesystem::create_directories(tmp_path, error);
+    if (error) return false;
+
+    std::ofstream manifest(tmp_path + "/" + MANIFEST_FILE);
+    manifest << "version " << version << '\n';
+    for (const auto &pkg_file : pkg_files) {
+        const std::string file_name = std::filesystem::path(pkg_file).filename().string();
+        const std::string checksum = SHA256_File(pkg_file);
+        // ? pacman -U picks the signature up from next to the package
+        if (!checksum.empty() && Link_File(pkg_file, tmp_path + "/" + file_name)
+            && (!std::filesystem::exists(pkg_file + ".sig") || Link_File(pkg_file + ".sig", tmp_path + "/" + file_name + ".sig"))) {
+            manifest << checksum << ' ' << file_name << '\n';
+            continue;
+        }
+        std::filesystem::remove_all(tmp_path, error);
+        return false;
+    }
+    manifest.close();
+    if (!manifest) {
+        std::filesystem::remove_all(tmp_path, error);
+        return false;
+    }
+
+    std::filesystem::remove_all(entry_path, error);
+    std::filesystem::rename(tmp_path, entry_path, error);
+    if (error) std::filesystem::remove_all(tmp_path, error);
+    return !error;
+}
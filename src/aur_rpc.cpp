@@ -0,0 +1,61 @@
+#include "../include/colours.hpp"
+#include "../include/rpc_client.hpp"
+#include "../include/json_stream.hpp"
+#include "../include/aur_rpc.hpp"
+#include <iostream>
+#include <memory>
+
+// ? aurweb rejects request URIs that are longer than this
+static const std::size_t MAX_URL_LENGTH = 4400;
+
+
+std::vector<std::string> Build_Info_URLs(const std::vector<std::string> &pkg_names)
+{
+    RPC_Client &client = AUR_Client();
+    const std::string info_url = client.Base_URL() + "/rpc/?v=5&type=info";
+    std::vector<std::string> urls;
+    std::string url = info_url;
+
+    for (const auto &pkg_name : pkg_names) {
+        const std::string arg = "&arg[]=" + client.Escape(pkg_name);
+
+        if (url.size() + arg.size() > MAX_URL_LENGTH && url.size() > info_url.size()) {
+            urls.push_back(url);
+            url = info_url;
+        }
+        url += arg;
+    }
+
+    if (url.size() > info_url.size()) urls.push_back(url);
+    return urls;
+}
+
+
+bool Fetch_PKG_Infos(const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos)
+{
+    RPC_Client &client = AUR_Client();
+    bool success = true;
+
+    // ? Every chunk is queued up front, so they run concurrently over the shared connections
+    for (const auto &url : Build_Info_URLs(pkg_names)) {
+        auto stream = std::make_shared<Result_Stream>([&pkg_infos](PKG_Info &&info) {
+            std::string pkg_name = info.name;
+            pkg_infos[pkg_name] = std::move(info);
+        });
+
+        client.Queue(url,
+            [stream](const char *data, std::size_t size) { return stream->Feed(data, size); },
+            [stream, &success](bool done, long) {
+                if (!done) {
+                    std::cerr << WARNING_COLOUR << "Failed to perform curl request.\n" << RESET;
+                    success = false;
+                } else if (!stream->Is_Complete()) {
+                    std::cerr << WARNING_COLOUR << "Invalid response from the AUR RPC: " << stream->Error() << '\n' << RESET;
+                    success = false;
+                }
+            });
+    }
+
+    client.Perform();
+    return success;
+}
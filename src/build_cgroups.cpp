@@ -0,0 +1,51 @@
+#include "../include/build_cgroups.hpp"
+#include "../include/command.hpp"
+#include <filesystem>
+#include <fstream>
+#include <cstdio>
+
+
+static const std::string BUILD_SLICE = "hone-builds.slice";
+// ? The default weight is 100
+static const std::string BUILD_CPU_WEIGHT = "20";
+
+
+Build_Cgroups::Build_Cgroups(long memory_max_kb)
+{
+    std::error_code error;
+    if (!std::filesystem::exists("/sys/fs/cgroup/cgroup.controllers", error)) return;
+
+    // ? Fails without a user systemd instance, as in containers or over plain su
+    if (Run_Command({ "systemd-run", "--user", "--scope", "--quiet", "--collect", "--slice=" + BUILD_SLICE, "true" })) return;
+    ready = true;
+
+    // ? The slice exists now, its limit holds until the user instance stops
+    if (memory_max_kb > 0) {
+        Run_Command({ "systemctl", "--user", "set-property", "--runtime", BUILD_SLICE, "MemoryMax=" + std::to_string(memory_max_kb) + "K" });
+    }
+}
+
+
+std::vector<std::string> Build_Cgroups::Wrap(const std::vector<std::string> &args) const
+{
+    if (!ready) return args;
+
+    // ? --scope runs the command in place, so working directory, environment and rusage stay as they were
+    std::vector<std::string> wrapped = { "systemd-run", "--user", "--scope", "--quiet", "--collect", "--slice=" + BUILD_SLICE,
+        "-p", "CPUWeight=" + BUILD_CPU_WEIGHT };
+    wrapped.push_back("--");
+    wrapped.insert(wrapped.end(), args.begin(), args.end());
+    return wrapped;
+}
+
+
+long Available_Memory_KB()
+{
+    std::ifstream meminfo("/proc/meminfo");
+    std::string line;
+    long available_kb = 0;
+    while (std::getline(meminfo, line)) {
+        if (std::sscanf(line.c_str(), "MemAvailable: %ld kB", &available_kb) == 1) return available_kb;
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "../include/build_history.hpp"
+#include <filesystem>
+#include <algorithm>
+#include <sstream>
+#include <fstream>
+#include <ctime>
+
+// ? Estimates follow the latest runs, so a package that got slower or faster is picked up quickly
+static const std::size_t RUNS_KEPT = 5;
+
+
+Build_History::Build_History(const std::string &history_file)
+    : history_file(history_file)
+{
+}
+
+
+bool Build_History::Load()
+{
+    std::lock_guard<std::mutex> lock(history_mutex);
+    if (loaded) return true;
+    loaded = true;
+
+    std::ifstream file(history_file);
+    if (!file) return false;
+
+    // ? One run per line: timestamp, package base, version, wall seconds, cpu seconds, peak rss in KiB
+    std::string line;
+    std::size_t line_count = 0;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string package_base;
+        Build_Run run;
+        if (!(fields >> run.timestamp >> package_base >> run.version >> run.usage.wall_seconds >> run.usage.cpu_seconds >> run.usage.peak_rss_kb)) continue;
+
+        std::vector<Build_Run> &base_runs = runs[package_base];
+        base_runs.push_back(std::move(run));
+        if (base_runs.size() > RUNS_KEPT) base_runs.erase(base_runs.begin());
+        line_count++;
+    }
+
+    if (line_count > runs.size() * RUNS_KEPT * 2) Compact();
+    return true;
+}
+
+
+// ? Rewrites the file with only the runs still used for estimates
+void Build_History::Compact()
+{
+    const std::string tmp_path = history_file + ".tmp";
+    std::ofstream file(tmp_path, std::ios::trunc);
+    for (const auto &[package_base, base_runs] : runs) {
+        for (const auto &run : base_runs) {
+            file << run.timestamp << ' ' << package_base << ' ' << run.version << ' ' << run.usage.wall_seconds << ' '
+                 << run.usage.cpu_seconds << ' ' << run.usage.peak_rss_kb << '\n';
+        }
+    }
+    file.close();
+
+    std::error_code error;
+    if (file) std::filesystem::rename(tmp_path, history_file, error);
+    else std::filesystem::remove(tmp_path, error);
+}
+
+
+void Build_History::Record(const std::string &package_base, const std::string &version, const Process_Usage &usage)
+{
+    Build_Run run{ static_cast<long long>(std::time(nullptr)), version, usage };
+
+    std::lock_guard<std::mutex> lock(history_mutex);
+    std::vector<Build_Run> &base_runs = runs[package_base];
+    base_runs.push_back(run);
+    if (base_runs.size() > RUNS_KEPT) base_runs.erase(base_runs.begin());
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(history_file).parent_path(), error);
+    std::ofstream file(history_file, std::ios::app);
+    file << run.timestamp << ' ' << package_base << ' ' << version << ' ' << usage.wall_seconds << ' '
+         << usage.cpu_seconds << ' ' << usage.peak_rss_kb << '\n';
+}
+
+
+double Build_History::Wall_Seconds(const std::string &package_base) const
+{
+    std::lock_guard<std::mutex> lock(history_mutex);
+    auto base_runs = runs.find(package_base);
+    if (base_runs == runs.end() || base_runs->second.empty()) return 0;
+
+    double total = 0;
+    for (const auto &run : base_runs->second) total += run.usage.wall_seconds;
+    return total / static_cast<double>(base_runs->second.size());
+}
+
+
+long Build_History::Peak_RSS_KB(const std::string &package_base) const
+{
+    std::lock_guard<std::mutex> lock(history_mutex);
+    auto base_runs = runs.find(package_base);
+    if (base_runs == runs.end()) return 0;
+
+    long peak = 0;
+    for (const auto &run : base_runs->second) peak = std::max(peak, run.usage.peak_rss_kb);
+    return peak;
+}
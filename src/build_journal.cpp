@@ -0,0 +1,158 @@
+#include "../include/build_journal.hpp"
+#include <filesystem>
+#include <iterator>
+#include <sstream>
+#include <fstream>
+
+// ? Fields are tab separated, so paths with spaces survive, list fields are comma separated
+static const char FIELD_SEPARATOR = '\t';
+static const char LIST_SEPARATOR = ',';
+
+static const char *STATE_NAMES[] = { "planned", "fetched", "built", "installed", "failed" };
+
+
+static std::vector<std::string> Split(const std::string &text, char separator)
+{
+    std::vector<std::string> parts;
+    std::istringstream stream(text);
+    std::string part;
+    while (std::getline(stream, part, separator)) parts.push_back(part);
+    return parts;
+}
+
+
+static std::string Join(const std::vector<std::string> &parts, char separator)
+{
+    std::string text;
+    for (const auto &part : parts) {
+        if (!text.empty()) text += separator;
+        text += part;
+    }
+    return text;
+}
+
+
+Build_Journal::Build_Journal(const std::string &journal_file)
+    : journal_file(journal_file)
+{
+}
+
+
+bool Build_Journal::Begin(const std::vector<std::string> &targets, const Build_Plan &plan)
+{
+    std::lock_guard<std::mutex> lock(journal_mutex);
+    progress.clear();
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(journal_file).parent_path(), error);
+
+    // ? Written aside first, so a crash never leaves half a plan behind
+    const std::string tmp_path = journal_file + ".tmp";
+    std::ofstream file(tmp_path, std::ios::trunc);
+    for (const auto &target : targets) file << "target" << FIELD_SEPARATOR << target << '\n';
+    for (const auto &node : plan.nodes) {
+        file << "node" << FIELD_SEPARATOR << node.package_base << FIELD_SEPARATOR << node.version << FIELD_SEPARATOR
+             << (node.is_dependency ? "dependency" : "explicit") << FIELD_SEPARATOR << Join(node.pkg_names, LIST_SEPARATOR)
+             << FIELD_SEPARATOR << Join(node.dependencies, LIST_SEPARATOR) << '\n';
+        progress[node.package_base] = Base_Progress();
+    }
+    for (const auto &pkg_name : plan.repo_depends) file << "repo" << FIELD_SEPARATOR << pkg_name << '\n';
+    for (const auto &pkg_name : plan.repo_make_depends) file << "make" << FIELD_SEPARATOR << pkg_name << '\n';
+    file.close();
+
+    if (!file) {
+        std::filesystem::remove(tmp_path, error);
+        return false;
+    }
+    std::filesystem::rename(tmp_path, journal_file, error);
+    return !error;
+}
+
+
+bool Build_Journal::Load(std::vector<std::string> &targets, Build_Plan &plan)
+{
+    std::lock_guard<std::mutex> lock(journal_mutex);
+    std::ifstream file(journal_file);
+    if (!file) return false;
+
+    targets.clear();
+    plan = Build_Plan();
+    progress.clear();
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields = Split(line, FIELD_SEPARATOR);
+        if (fields.size() < 2) continue;
+        const std::string &kind = fields[0];
+
+        if (kind == "target") targets.push_back(fields[1]);
+        else if (kind == "repo") plan.repo_depends.push_back(fields[1]);
+        else if (kind == "make") plan.repo_make_depends.push_back(fields[1]);
+        else if (kind == "node" && fields.size() >= 5) {
+            Build_Node node;
+            node.package_base = fields[1];
+            node.version = fields[2];
+            node.is_dependency = fields[3] == "dependency";
+            node.pkg_names = Split(fields[4], LIST_SEPARATOR);
+            if (fields.size() > 5) node.dependencies = Split(fields[5], LIST_SEPARATOR);
+            progress[node.package_base] = Base_Progress();
+            plan.nodes.push_back(std::move(node));
+        } else {
+            // ? A state line, only the last one of each base counts
+            auto base_progress = progress.find(fields[1]);
+            if (base_progress == progress.end()) continue;
+            for (std::size_t state = 0; state < std::size(STATE_NAMES); state++) {
+                if (kind != STATE_NAMES[state]) continue;
+                base_progress->second.state = static_cast<Journal_State>(state);
+                base_progress->second.pkg_files.assign(fields.begin() + 2, fields.end());
+            }
+        }
+    }
+    return !plan.nodes.empty();
+}
+
+
+void Build_Journal::Finish()
+{
+    std::lock_guard<std::mutex> lock(journal_mutex);
+    progress.clear();
+    std::error_code error;
+    std::filesystem::remove(journal_file, error);
+}
+
+
+void Build_Journal::Record(const std::string &package_base, Journal_State state, const std::vector<std::string> &pkg_files)
+{
+    std::lock_guard<std::mutex> lock(journal_mutex);
+    Base_Progress &base_progress = progress[package_base];
+    base_progress.state = state;
+    base_progress.pkg_files = pkg_files;
+
+    // ? Appended and closed right away, so the line outlives hone getting killed in the next step
+    std::ofstream file(journal_file, std::ios::app);
+    file << STATE_NAMES[static_cast<std::size_t>(state)] << FIELD_SEPARATOR << package_base;
+    for (const auto &pkg_file : pkg_files) file << FIELD_SEPARATOR << pkg_file;
+    file << '\n';
+}
+
+
+Journal_State Build_Journal::State(const std::string &package_base) const
+{
+    std::lock_guard<std::mutex> lock(journal_mutex);
+    auto base_progress = progress.find(package_base);
+    return base_progress == progress.end() ? Journal_State::Planned : base_progress->second.state;
+}
+
+
+bool Build_Journal::Built_Files(const std::string &package_base, std::vector<std::string> &pkg_files) const
+{
+    std::lock_guard<std::mutex> lock(journal_mutex);
+    auto base_progress = progress.find(package_base);
+    if (base_progress == progress.end() || base_progress->second.state != Journal_State::Built) return false;
+
+    for (const auto &pkg_file : base_progress->second.pkg_files) {
+        if (!std::filesystem::exists(pkg_file)) return false;
+    }
+    pkg_files = base_progress->second.pkg_files;
+    return !pkg_files.empty();
+}
@@ -0,0 +1,302 @@
+#include "../include/colours.hpp"
+#include "../include/build_scheduler.hpp"
+#include <condition_variable>
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <deque>
+
+
+Build_Scheduler::Build_Scheduler(std::size_t jobs, std::size_t fetch_jobs, Fetch_Step fetch, Build_Step build, Install_Step install,
+    Cost_Estimate estimate)
+    : jobs(jobs ? jobs : 1), fetch_jobs(fetch_jobs ? fetch_jobs : 1), fetch(std::move(fetch)), build(std::move(build)), install(std::move(install)),
+      estimate(std::move(estimate))
+{
+}
+
+
+void Build_Scheduler::Limit_Memory(long budget_kb, Memory_Estimate memory_estimate)
+{
+    memory_budget_kb = budget_kb;
+    this->memory_estimate = std::move(memory_estimate);
+}
+
+
+std::vector<double> Build_Scheduler::Chain_Costs(const std::vector<Build_Node> &nodes, const std::vector<std::vector<std::size_t>> &dependents,
+    std::vector<double> &costs) const
+{
+    // ? Bases never built before count as the average of the known ones, or all the same when none is known
+    costs.assign(nodes.size(), 0);
+    double known_total = 0;
+    std::size_t known_count = 0;
+    for (std::size_t i = 0; i < nodes.size() && estimate; i++) {
+        costs[i] = estimate(nodes[i]);
+        if (costs[i] <= 0) continue;
+        known_total += costs[i];
+        known_count++;
+    }
+    const double default_cost = known_count ? known_total / static_cast<double>(known_count) : 1;
+    for (auto &cost : costs) {
+        if (cost <= 0) cost = default_cost;
+    }
+
+    // ? Plan order is topological, so walking it backwards sees every dependent before its dependency
+    std::vector<double> chain_costs(nodes.size(), 0);
+    for (std::size_t i = nodes.size(); i-- > 0;) {
+        double longest_dependent = 0;
+        for (std::size_t dependent : dependents[i]) longest_dependent = std::max(longest_dependent, chain_costs[dependent]);
+        chain_costs[i] = costs[i] + longest_dependent;
+    }
+    return chain_costs;
+}
+
+
+static std::string Format_Duration(double seconds)
+{
+    long total = static_cast<long>(seconds + 0.5);
+    if (total < 60) return std::to_string(total) + "s";
+    std::string minutes = std::to_string(total / 60) + "m";
+    if (total < 3600) return minutes + (total % 60 < 10 ? "0" : "") + std::to_string(total % 60) + "s";
+    return std::to_string(total / 3600) + "h" + (total / 60 % 60 < 10 ? "0" : "") + std::to_string(total / 60 % 60) + "m";
+}
+
+
+bool Build_Scheduler::Run(const Build_Plan &plan)
+{
+    const std::vector<Build_Node> &nodes = plan.nodes;
+    std::unordered_map<std::string, std::size_t> index_of;
+    std::vector<std::size_t> pending_count(nodes.size());
+    std::vector<std::vector<std::size_t>> dependents(nodes.size());
+
+    for (std::size_t i = 0; i < nodes.size(); i++) index_of[nodes[i].package_base] = i;
+    for (std::size_t i = 0; i < nodes.size(); i++) {
+        for (const auto &dependency : nodes[i].dependencies) {
+            auto dependency_index = index_of.find(dependency);
+            if (dependency_index == index_of.end()) continue;
+            pending_count[i]++;
+            dependents[dependency_index->second].push_back(i);
+        }
+    }
+
+    std::vector<double> costs;
+    const std::vector<double> chain_costs = Chain_Costs(nodes, dependents, costs);
+    // ? Longest remaining chain first, plan order between equals
+    auto By_Priority = [&chain_costs](std::size_t a, std::size_t b) {
+        return chain_costs[a] != chain_costs[b] ? chain_costs[a] > chain_costs[b] : a < b;
+    };
+
+    // ? Ready nodes have all their dependencies installed, they start by priority once fetched
+    std::vector<std::size_t> ready;
+    for (std::size_t i = 0; i < nodes.size(); i++) {
+        if (pending_count[i] == 0) ready.push_back(i);
+    }
+
+    struct Finished_Build {
+        std::size_t index;
+        bool success;
+        bool is_fetch;
+        std::vector<std::string> pkg_files;
+    };
+
+    std::mutex finished_mutex;
+    std::condition_variable finished_signal;
+    std::deque<Finished_Build> finished;
+    std::unordered_map<std::size_t, std::thread> running;
+    std::unordered_map<std::size_t, std::chrono::steady_clock::time_point> start_times;
+    std::vector<bool> done(nodes.size(), false);
+    // ? Predicted peak memory of every running build, and whether a node was already reported as waiting for it
+    std::unordered_map<std::size_t, long> running_memory;
+    long running_memory_total = 0;
+    std::vector<bool> held_back(nodes.size(), false);
+    // ? Built, but not installed yet. Only the first kind holds up other builds
+    std::vector<Built_Node> blocking_installs;
+    std::vector<Built_Node> final_installs;
+    std::size_t installed_count = 0;
+    std::vector<bool> fetched(nodes.size(), false);
+    std::size_t fetched_count = 0;
+    // ? Only an install failure stops the whole run
+    bool failed = false;
+    // ? Failed nodes and everything depending on them, fetch threads read it under finished_mutex
+    std::vector<bool> abandoned(nodes.size(), false);
+    std::size_t failed_count = 0;
+    std::size_t skipped_count = 0;
+
+    // ? The fetch threads walk the nodes by priority, so the next builds are always the next downloads
+    std::vector<std::size_t> fetch_order(nodes.size());
+    for (std::size_t i = 0; i < nodes.size(); i++) fetch_order[i] = i;
+    std::sort(fetch_order.begin(), fetch_order.end(), By_Priority);
+    std::atomic<std::size_t> next_fetch{ 0 };
+    std::atomic<bool> stop_fetching{ false };
+    std::vector<std::thread> fetchers;
+    for (std::size_t i = 0; i < std::min(fetch_jobs, nodes.size()); i++) {
+        fetchers.emplace_back([&]() {
+            while (!stop_fetching) {
+                std::size_t position = next_fetch++;
+                if (position >= nodes.size()) return;
+                std::size_t index = fetch_order[position];
+                bool skip = false;
+                {
+                    std::lock_guard<std::mutex> lock(finished_mutex);
+                    skip = abandoned[index];
+                }
+                bool success = skip || fetch(nodes[index]);
+                std::lock_guard<std::mutex> lock(finished_mutex);
+                finished.push_back({ index, success, true, {} });
+                finished_signal.notify_one();
+            }
+        });
+    }
+
+    auto Install_Blocking = [&]() {
+        if (!install(blocking_installs)) {
+            std::cerr << WARNING_COLOUR << "Failed to install built dependencies!\n" << RESET;
+            failed = true;
+            return;
+        }
+
+        for (const auto &built : blocking_installs) {
+            std::size_t index = index_of[built.node->package_base];
+            for (std::size_t dependent : dependents[index]) {
+                if (--pending_count[dependent] == 0) ready.push_back(dependent);
+            }
+        }
+        installed_count += blocking_installs.size();
+        blocking_installs.clear();
+    };
+
+    // ? None of the dependents can be ready or running, the failed node was never installed
+    auto Abandon = [&](std::size_t index) {
+        if (abandoned[index]) return;
+        failed_count++;
+        done[index] = true;
+        std::lock_guard<std::mutex> lock(finished_mutex);
+        abandoned[index] = true;
+        std::vector<std::size_t> to_skip = dependents[index];
+        while (!to_skip.empty()) {
+            std::size_t dependent = to_skip.back();
+            to_skip.pop_back();
+            if (abandoned[dependent]) continue;
+            abandoned[dependent] = true;
+            done[dependent] = true;
+            skipped_count++;
+            std::cerr << WARNING_COLOUR << "Skipping " << nodes[dependent].package_base << ", it depends on " << nodes[index].package_base << '\n' << RESET;
+            to_skip.insert(to_skip.end(), dependents[dependent].begin(), dependents[dependent].end());
+        }
+    };
+
+    // ? Whichever is longer: the longest chain still ahead, or the remaining work spread over every job
+    auto Remaining_Time = [&]() {
+        const auto now = std::chrono::steady_clock::now();
+        double critical_path = 0;
+        double total_work = 0;
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            if (done[i]) continue;
+            double elapsed = 0;
+            auto start_time = start_times.find(i);
+            if (start_time != start_times.end()) elapsed = std::chrono::duration<double>(now - start_time->second).count();
+            critical_path = std::max(critical_path, chain_costs[i] - elapsed);
+            total_work += std::max(costs[i] - elapsed, 0.0);
+        }
+        return std::max(critical_path, total_work / static_cast<double>(jobs));
+    };
+    const bool show_eta = estimate && std::any_of(nodes.begin(), nodes.end(), [this](const Build_Node &node) { return estimate(node) > 0; });
+
+    while (true) {
+        std::sort(ready.begin(), ready.end(), By_Priority);
+        for (auto it = ready.begin(); !failed && running.size() < jobs && it != ready.end();) {
+            std::size_t index = *it;
+            if (!fetched[index]) {
+                ++it;
+                continue;
+            }
+
+            const long memory = memory_budget_kb > 0 && memory_estimate ? memory_estimate(nodes[index]) : 0;
+            if (!running.empty() && running_memory_total + memory > memory_budget_kb && memory > 0) {
+                if (!held_back[index]) {
+                    std::cout << "Waiting for memory to build " << NAME_COLOUR << nodes[index].package_base << RESET << "...\n";
+                    held_back[index] = true;
+                }
+                ++it;
+                continue;
+            }
+            it = ready.erase(it);
+            running_memory[index] = memory;
+            running_memory_total += memory;
+
+            start_times[index] = std::chrono::steady_clock::now();
+            std::cout << "Building " << NAME_COLOUR << nodes[index].package_base << RESET << "...";
+            if (show_eta) std::cout << " (about " << Format_Duration(Remaining_Time()) << " left)";
+            std::cout << '\n';
+            running.emplace(index, std::thread([&, index]() {
+                std::vector<std::string> pkg_files;
+                bool success = build(nodes[index], pkg_files);
+                std::lock_guard<std::mutex> lock(finished_mutex);
+                finished.push_back({ index, success, false, std::move(pkg_files) });
+                finished_signal.notify_one();
+            }));
+        }
+
+        // ? Nothing left to start until some dependencies get installed
+        bool can_start = std::any_of(ready.begin(), ready.end(), [&fetched](std::size_t index) { return fetched[index]; });
+        if (!failed && !can_start && !blocking_installs.empty()) {
+            Install_Blocking();
+            continue;
+        }
+
+        if (running.empty() && (failed || fetched_count == nodes.size())) break;
+
+        std::unique_lock<std::mutex> lock(finished_mutex);
+        finished_signal.wait(lock, [&finished]() { return !finished.empty(); });
+        std::deque<Finished_Build> batch;
+        batch.swap(finished);
+        lock.unlock();
+
+        for (auto &build_result : batch) {
+            if (build_result.is_fetch) {
+                fetched_count++;
+                fetched[build_result.index] = build_result.success;
+                // ? A node skipped for a failed dependency may still have been fetching, it was reported already
+                if (!build_result.success && !abandoned[build_result.index]) {
+                    std::cerr << WARNING_COLOUR << "Failed to fetch package: " << nodes[build_result.index].package_base << '\n' << RESET;
+                    Abandon(build_result.index);
+                }
+                continue;
+            }
+
+            running[build_result.index].join();
+            running.erase(build_result.index);
+            running_memory_total -= running_memory[build_result.index];
+            running_memory.erase(build_result.index);
+            done[build_result.index] = true;
+
+            if (!build_result.success) {
+                std::cerr << WARNING_COLOUR << "Failed to build package: " << nodes[build_result.index].package_base << '\n' << RESET;
+                Abandon(build_result.index);
+                continue;
+            }
+
+            Built_Node built{ &nodes[build_result.index], std::move(build_result.pkg_files) };
+            if (dependents[build_result.index].empty()) final_installs.push_back(std::move(built));
+            else blocking_installs.push_back(std::move(built));
+        }
+    }
+
+    // ? The loop also ends on a failed install, with fetches still going
+    stop_fetching = true;
+    for (auto &fetcher : fetchers) fetcher.join();
+
+    if (failed) return false;
+    if (!final_installs.empty()) {
+        if (!install(final_installs)) return false;
+        installed_count += final_installs.size();
+    }
+    if (failed_count) {
+        std::cerr << WARNING_COLOUR << failed_count << (failed_count == 1 ? " package base" : " package bases") << " failed, "
+                  << skipped_count << " skipped, " << installed_count << " installed\n" << RESET;
+    }
+    return installed_count == nodes.size();
+}
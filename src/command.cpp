@@ -0,0 +1,41 @@
+#include "../include/command.hpp"
+#include "../include/process.hpp"
+
+
+int32_t Run_Command(const std::vector<std::string> &args, const std::string &working_dir, const std::string &log_file,
+    const std::vector<std::string> &environment, Process_Usage *usage, const std::vector<int> &inherit_fds)
+{
+    Process_Options options;
+    options.args = args;
+    options.working_dir = working_dir;
+    options.log_file = log_file;
+    options.environment = environment;
+    options.sample_memory = usage != nullptr;
+    options.inherit_fds = inherit_fds;
+
+    int32_t exit_code = 127;
+    Process_Group group;
+    bool spawned = group.Spawn(options, [&exit_code, usage](int32_t code, const Process_Usage &child_usage) {
+        exit_code = code;
+        if (usage) *usage = child_usage;
+    });
+    if (!spawned) return 127;
+    group.Wait();
+    return exit_code;
+}
+
+
+bool Read_Command(const std::vector<std::string> &args, const std::string &working_dir, std::string &output)
+{
+    Process_Options options;
+    options.args = args;
+    options.working_dir = working_dir;
+    options.capture_output = true;
+
+    int32_t exit_code = 127;
+    Process_Group group;
+    if (!group.Spawn(options, [&exit_code](int32_t code, const Process_Usage &) { exit_code = code; },
+            [&output](const char *data, std::size_t size) { output.append(data, size); })) return false;
+    group.Wait();
+    return exit_code == 0;
+}
@@ -0,0 +1,60 @@
+#include "../include/dependency.hpp"
+#include "../include/vercmp.hpp"
+
+
+Dependency Parse_Dependency(std::string_view text)
+{
+    Dependency dep;
+    std::size_t op_start = text.find_first_of("<>=");
+    if (op_start == std::string_view::npos) {
+        dep.name = text;
+        return dep;
+    }
+
+    std::size_t op_end = text.find_first_not_of("<>=", op_start);
+    if (op_end == std::string_view::npos) op_end = text.size();
+
+    dep.name = text.substr(0, op_start);
+    dep.op = text.substr(op_start, op_end - op_start);
+    dep.version = text.substr(op_end);
+    return dep;
+}
+
+
+bool Satisfies(const Dependency &dep, std::string_view name, std::string_view version)
+{
+    if (dep.name != name) return false;
+    if (dep.op.empty()) return true;
+    // ? An unversioned provide never satisfies a versioned dependency
+    if (version.empty()) return false;
+
+    int32_t result = Vercmp(version, dep.version);
+    if (dep.op == "=") return result == 0;
+    if (dep.op == ">=") return result >= 0;
+    if (dep.op == "<=") return result <= 0;
+    if (dep.op == ">") return result > 0;
+    if (dep.op == "<") return result < 0;
+    return false;
+}
+
+
+void Provides_Map::Add(const std::string &pkg_name, const std::string &pkg_version, const std::vector<std::string> &provides)
+{
+    providers[pkg_name].push_back(pkg_version);
+    for (const auto &provide : provides) {
+        Dependency provided = Parse_Dependency(provide);
+        providers[provided.name].push_back(provided.op == "=" ? provided.version : "");
+    }
+}
+
+
+bool Provides_Map::Satisfies(const Dependency &dep) const
+{
+    auto provider = providers.find(dep.name);
+    if (provider == providers.end()) return false;
+
+    for (const auto &version : provider->second) {
+        if (::Satisfies(dep, dep.name, version)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,63 @@
+#include "../include/gzip_stream.hpp"
+#include <algorithm>
+
+static const std::size_t MAGIC_SIZE = 2;
+
+
+Gzip_Stream::Gzip_Stream(Gzip_Sink sink)
+    : sink(std::move(sink))
+{
+    stream_ready = inflateInit2(&stream, 15 + 32) == Z_OK;
+}
+
+
+Gzip_Stream::~Gzip_Stream()
+{
+    if (stream_ready) inflateEnd(&stream);
+}
+
+
+bool Gzip_Stream::Feed(const char *data, std::size_t size)
+{
+    if (!stream_ready) return false;
+
+    if (!checked_magic) {
+        std::size_t take = std::min(size, MAGIC_SIZE - magic.size());
+        magic.append(data, take);
+        data += take;
+        size -= take;
+        if (magic.size() < MAGIC_SIZE) return true;
+
+        compressed = static_cast<unsigned char>(magic[0]) == 0x1f && static_cast<unsigned char>(magic[1]) == 0x8b;
+        checked_magic = true;
+        if (!Forward(magic.data(), magic.size())) return false;
+    }
+    return size == 0 || Forward(data, size);
+}
+
+
+bool Gzip_Stream::Finish()
+{
+    if (checked_magic || magic.empty()) return true;
+    checked_magic = true;
+    return Forward(magic.data(), magic.size());
+}
+
+
+bool Gzip_Stream::Forward(const char *data, std::size_t size)
+{
+    if (!compressed) return sink(data, size);
+
+    char out[65536];
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+    while (stream.avail_in > 0) {
+        stream.next_out = reinterpret_cast<Bytef*>(out);
+        stream.avail_out = sizeof(out);
+        int ret = inflate(&stream, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END) return false;
+        if (!sink(out, sizeof(out) - stream.avail_out)) return false;
+        if (ret == Z_STREAM_END) break;
+    }
+    return true;
+}
@@ -1,23 +1,45 @@
 #include "../include/colours.hpp"
 #include "../include/CLI11.hpp"
-#include <nlohmann/json.hpp>
-#include <curl/curl.h>
+#include "../include/rpc_client.hpp"
+#include "../include/metadata_snapshot.hpp"
+#include "../include/installed_store.hpp"
+#include "../include/build_scheduler.hpp"
+#include "../include/json_stream.hpp"
+#include "../include/command.hpp"
+#include "../include/resolver.hpp"
+#include "../include/sync_db.hpp"
+#include "../include/vercmp.hpp"
+#include "../include/aur_rpc.hpp"
+#include "../include/tar_stream.hpp"
+#include "../include/source_cache.hpp"
+#include "../include/artifact_cache.hpp"
+#include "../include/substituter.hpp"
+#include "../include/session.hpp"
+#include "../include/jobserver.hpp"
+#include "../include/build_history.hpp"
+#include "../include/build_cgroups.hpp"
+#include "../include/build_journal.hpp"
+#include "../include/dependency.hpp"
+#include "../include/srcinfo.hpp"
 #include <filesystem>
 #include <iostream>
 #include <cstdlib>
+#include <ctime>
 #include <fstream>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <unordered_map>
 #include <string>
 #include <vector>
 #include <mutex>
 #include <regex>
 
-using json = nlohmann::json;
-
 
 class AUR_Helper {
 public:
-    int32_t Start(const std::string &install_query, const std::string &remove_query, const std::string &search_query, bool only_name, bool is_list, bool update, bool no_syu)
+    int32_t Start(const std::vector<std::string> &install_query, const std::vector<std::string> &remove_query, const std::string &search_query, bool only_name, bool is_list, bool update, bool no_syu, bool refresh, bool tarball, std::size_t jobs, const std::string &repo_dir, const std::vector<std::string> &substitutes, bool resume)
     {
         // ? Restrict the use of multiple arguments
         if (Is_More_Than_One_Options(install_query, remove_query, search_query, is_list, update)) {
@@ -34,11 +56,24 @@ public:
             std::cerr << "Error: Do not use --no-sysupgrade outside of --update!\n";
             return ERR_CODE;
         }
+        if (resume && !update) {
+            std::cerr << "Error: Do not use --resume outside of --update!\n";
+            return ERR_CODE;
+        }
 
-        if (!remove_query.empty()) Remove_Installed_PKG(remove_query);
-        else if (!install_query.empty()) Install_AUR_PKG(install_query);
-        else if (!search_query.empty()) Search_PKGs(search_query, only_name);
-        else if (update) Perform_Upgrades(no_syu);
+        build_jobs = jobs;
+        use_tarballs = tarball;
+        substituter = std::make_unique<Substituter>(substitutes, artifact_cache);
+        local_repo_dir = repo_dir.empty() ? "" : std::filesystem::absolute(repo_dir).string();
+
+        // ? --refresh can run on its own, or ahead of any other option
+        if (refresh && !snapshot.Refresh()) return ERR_CODE;
+
+        // ? The exit status tells scripts whether the operation worked, and whether an update needs --resume
+        if (!remove_query.empty()) return Remove_Installed_PKG(remove_query);
+        if (!install_query.empty()) return Install_AUR_PKG(install_query);
+        if (update) return Perform_Upgrades(no_syu, resume);
+        if (!search_query.empty()) Search_PKGs(search_query, only_name);
         else if (is_list) Print_PKG_List();
         return SUCCESS_CODE;
     }
@@ -48,6 +83,47 @@ private:
     const int32_t ERR_CODE = 1;
     const std::string HOME_DIR = std::getenv("HOME");
     const std::string INSTALL_PATH = HOME_DIR + "/.cache/hone/";
+    // ? Package names can not start with a period, so this never collides with a clone directory
+    const std::string METADATA_PATH = INSTALL_PATH + ".metadata/";
+    const std::time_t SNAPSHOT_MAX_AGE = 24 * 60 * 60;
+    // ? HONE_DBPATH points hone at another pacman database, like pacman --dbpath
+    const std::string PACMAN_DB_PATH = std::getenv("HONE_DBPATH") ? std::getenv("HONE_DBPATH") : "/var/lib/pacman/";
+
+    Metadata_Snapshot snapshot{METADATA_PATH};
+    Installed_Store installed{PACMAN_DB_PATH, METADATA_PATH + "local.cache"};
+    Sync_DB sync_db{PACMAN_DB_PATH};
+    Session session{[this](const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos) { return Lookup_PKG_Infos(pkg_names, pkg_infos); }};
+    const std::string LOG_PATH = INSTALL_PATH + ".logs/";
+    // ? Bare repositories of every package built so far, they outlive the worktrees in INSTALL_PATH
+    const std::string MIRROR_PATH = INSTALL_PATH + ".mirrors/";
+    const std::uintmax_t SOURCE_CACHE_MAX_SIZE = std::uintmax_t(4) << 30;
+    Source_Cache source_cache{INSTALL_PATH + ".sources/", SOURCE_CACHE_MAX_SIZE};
+    Artifact_Cache artifact_cache{INSTALL_PATH + ".artifacts/"};
+    std::unique_ptr<Substituter> substituter;
+    std::atomic<std::size_t> artifact_cache_hits{ 0 };
+    std::atomic<std::size_t> artifact_cache_misses{ 0 };
+    // ? Time and memory of past makepkg runs, the scheduler starts the longest chains first from it
+    Build_History history{METADATA_PATH + "build_history"};
+    // ? Builds read the installed set while the scheduler installs their dependencies
+    std::mutex installed_mutex;
+    // ? Version every package of the running plan gets installed at, so a base hashes the same while fetching
+    // ? as when it builds after its dependencies got installed
+    std::unordered_map<std::string, std::string> planned_versions;
+    std::size_t build_jobs = 1;
+    // ? Downloads are bound by the network rather than the CPU, so they do not follow --jobs
+    const std::size_t FETCH_JOBS = 4;
+    // ? Set up while several packages build at once, their makes then share one pool of job slots
+    std::unique_ptr<Jobserver> jobserver;
+    // ? Set up with the jobserver, every makepkg -cf then runs in a cgroup scope of its own
+    std::unique_ptr<Build_Cgroups> build_cgroups;
+    // ? Assumed for bases without recorded builds
+    const long DEFAULT_BUILD_MEMORY_KB = 1024 * 1024;
+    // ? Only kept for -U, so an update that stopped halfway can go on with --resume
+    std::unique_ptr<Build_Journal> journal;
+    bool use_tarballs = false;
+    // ? With --repo, every built package also goes into a pacman repository there
+    std::string local_repo_dir;
+    const std::string LOCAL_REPO_NAME = "hone";
 
 
     bool Does_Install_Dir_Exists()
@@ -56,7 +132,7 @@ private:
     }
 
 
-    bool Is_More_Than_One_Options(const std::string &install_query, const std::string &remove_query, const std::string &search_query, bool is_list, bool update)
+    bool Is_More_Than_One_Options(const std::vector<std::string> &install_query, const std::vector<std::string> &remove_query, const std::string &search_query, bool is_list, bool update)
     {
         int8_t option_count = 0;
         if (!install_query.empty()) option_count++;
@@ -68,138 +144,97 @@ private:
         return option_count > 1;
     }
 
-    // ? Callback function to write response data from curl
-    static std::size_t Write_Callback(void *contents, std::size_t size, std::size_t nmemb, std::string *userp)
+    void Print_Search_Result(const PKG_Info &pkg, bool only_name)
     {
-        userp->append(static_cast<char*>(contents), size * nmemb);
-        return size * nmemb;
+        if (only_name) {
+            std::cout << pkg.name << '\n';
+            return;
+        }
+
+        std::string pkg_desc = !pkg.description.empty() ? pkg.description : "No description available";
+        std::string pkg_version = !pkg.version.empty() ? pkg.version : "Unknown";
+        std::string installed_text = installed.Contains(pkg.name) ? "(Installed)" : "";
+
+        std::cout << NAME_COLOUR + pkg.name << ' ' << VERSION_COLOUR + pkg_version << ' ' << INSTALLED_COLOUR + installed_text << '\n';
+        std::cout << "    " << RESET + pkg_desc << '\n';
     }
 
 
-    bool Is_PKG_Installed(const std::string &pkg_name)
+    // ? Results are printed while the reply is still arriving, nothing but the current result is kept
+    bool Search_AUR(const std::string &search_query, bool only_name, std::size_t &result_count)
     {
-        const std::string command = "pacman -Q " + pkg_name + " 2>/dev/null";
-        std::string result;
+        RPC_Client &client = AUR_Client();
+        std::regex include_pattern(".*" + std::regex_replace(search_query, std::regex(R"([.*+?^${}()|\[\]\\])"), R"(\\$&)") + ".*", std::regex_constants::icase);
 
-        auto pipe = popen(command.c_str(), "r");
-        if (!pipe) {
-            std::cerr << WARNING_COLOUR << "popen() failed in Is_PKG_Installed(): " << strerror(errno) << '\n';
-            return false;
-        }
+        Result_Stream stream([&](PKG_Info &&pkg) {
+            if (!std::regex_match(pkg.name, include_pattern)) return;
+            Print_Search_Result(pkg, only_name);
+            result_count++;
+        });
 
-        char buffer[128];
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) result += buffer;
+        bool success = false;
+        std::string url = client.Base_URL() + "/rpc/?v=5&type=search&arg=" + client.Escape(search_query);
+        client.Queue(url,
+            [&stream](const char *data, std::size_t size) { return stream.Feed(data, size); },
+            [&success](bool done, long) { success = done; });
+        client.Perform();
 
-        if (pclose(pipe) == -1) {
-            std::cerr << WARNING_COLOUR << "pclose() failed in Is_PKG_Installed(): " << strerror(errno) << '\n';
+        if (!success) {
+            std::cerr << WARNING_COLOUR << "Failed to perform curl request.\n";
             return false;
         }
-
-        return !result.empty();
+        if (!stream.Is_Complete()) {
+            std::cerr << WARNING_COLOUR << "Invalid response from the AUR RPC: " << stream.Error() << '\n' << RESET;
+            return false;
+        }
+        return true;
     }
 
 
     void Search_PKGs(const std::string &search_query, bool only_name)
     {
-        CURL *curl = curl_easy_init();;
-        std::string read_buffer;
-        if (!curl) return;
-        CURLcode res;
-
-        std::string url = "https://aur.archlinux.org/rpc/?v=5&type=search&arg=" + search_query; 
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, Write_Callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &read_buffer);
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-
-        if (curl_easy_perform(curl) != CURLE_OK) {
-            std::cerr << WARNING_COLOUR << "Failed to perform curl request.\n";
-            curl_easy_cleanup(curl);
-            return;
-        }
-        curl_easy_cleanup(curl);
+        std::size_t result_count = 0;
+        if (!only_name) installed.Load();
 
-        // ? Parse json response
-        auto json_response = json::parse(read_buffer);
-        if (!json_response["resultcount"]) {
-            std::cout << "No packages found.\n";
-            return;
-        }
-
-        std::regex include_pattern(".*" + std::regex_replace(search_query, std::regex(R"([.*+?^${}()|\[\]\\])"), R"(\\$&)") + ".*", std::regex_constants::icase);
-        for (const auto &pkg : json_response["results"]) {
-            std::string pkg_name = pkg.value("Name", "Unknown");
-
-            if (std::regex_match(pkg_name, include_pattern)) {
-                if (only_name) {
-                    std::cout << pkg_name << '\n';
-                    continue;
-                }
-
-                std::string pkg_desc = pkg.contains("Description") ? pkg["Description"] : "No description available";
-                std::string pkg_version = pkg.contains("Version") ? pkg["Version"] : "Unknown";
-                std::string installed_text = Is_PKG_Installed(pkg_name) ? "(Installed)" : "";
-                std::string pkg_name = pkg.contains("Name") ? pkg["Name"] : "Unknown";
-
-                std::cout << NAME_COLOUR + pkg_name << ' ' << VERSION_COLOUR + pkg_version << ' ' << INSTALLED_COLOUR + installed_text << '\n';
-                std::cout << "    " << RESET + pkg_desc << '\n';
+        if (snapshot.Load()) {
+            for (const auto &pkg : snapshot.Search(search_query)) {
+                Print_Search_Result(pkg, only_name);
+                result_count++;
             }
-        }
+        } else if (!Search_AUR(search_query, only_name, result_count)) return;
+
+        if (result_count == 0) std::cout << "No packages found.\n";
     }
 
 
-    std::string Get_PKG_Version(const std::string &pkg_name)
+    // ? Answers from the local snapshot when there is one, otherwise asks the AUR
+    // ? Every AUR lookup of the run goes through the session, so each name is asked for once at most
+    bool Get_PKG_Infos(const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos)
     {
-        std::string read_buffer;
-        CURL *curl = curl_easy_init();
-        if (!curl) return "Not found";
-
-        std::string url = "https://aur.archlinux.org/rpc/?v=5&type=info&arg=" + pkg_name;
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, Write_Callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &read_buffer);
-        curl_easy_setopt(curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-
-        if (curl_easy_perform(curl) != CURLE_OK) {
-            std::cerr << "Failed to perform curl request.\n";
-            curl_easy_cleanup(curl);
-            return "Failed to perform curl request";
-        }
-        curl_easy_cleanup(curl);
-
-        auto json_response = json::parse(read_buffer);
-        if (json_response["resultcount"] > 0) return json_response["results"][0]["Version"];
-        return "Not found";
+        return session.PKG_Infos(pkg_names, pkg_infos);
     }
 
 
-    std::vector<std::string> Get_PKG_List()
+    bool Lookup_PKG_Infos(const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos)
     {
-        const std::string command = "pacman -Qm";
-        std::vector<std::string> pkg_list;
-
-        auto pipe = popen(command.c_str(), "r");
-        if (!pipe) {
-            std::cerr << WARNING_COLOUR << "popen() failed in Is_PKG_Installed(): " << strerror(errno) << '\n';
-            return pkg_list;
-        }
+        if (!snapshot.Load()) return Fetch_PKG_Infos(pkg_names, pkg_infos);
 
-        char buffer[128];
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
-            pkg_list.push_back(buffer);
+        if (std::time(nullptr) - snapshot.Last_Refresh() > SNAPSHOT_MAX_AGE) {
+            std::cerr << WARNING_COLOUR << "WARNING: " << RESET << "AUR metadata snapshot is older than a day, run hone --refresh.\n";
         }
 
-        if (pclose(pipe) == -1) {
-            std::cerr << WARNING_COLOUR << "pclose() failed in Is_PKG_Installed(): " << strerror(errno) << '\n';
-            return pkg_list;
+        for (const auto &pkg_name : pkg_names) {
+            PKG_Info info;
+            if (snapshot.Find(pkg_name, info)) pkg_infos[pkg_name] = std::move(info);
         }
-        return pkg_list;
+        return true;
     }
 
 
     void Print_PKG_List()
     {
-        const std::vector<std::string> pkg_list = Get_PKG_List();
+        installed.Load();
+        const std::vector<Installed_PKG> pkg_list = installed.Foreign();
 
         if (pkg_list.empty()) {
             std::cout << "No packages installed.\n";
@@ -207,96 +242,440 @@ private:
         }
 
         for (const auto &pkg : pkg_list) {
-            std::istringstream iss(pkg);
-            std::string pkg_version;
-            std::string pkg_name;
-            iss >> pkg_name >> pkg_version;
-
-            std::cout << NAME_COLOUR << pkg_name << ' ' << VERSION_COLOUR << pkg_version << RESET << '\n';
+            std::cout << NAME_COLOUR << pkg.name << ' ' << VERSION_COLOUR << pkg.version << RESET << '\n';
         }
     }
 
 
-    int32_t Perform_Upgrades(const bool &no_syu)
+    int32_t Perform_Upgrades(const bool &no_syu, const bool &resume)
     {
+        journal = std::make_unique<Build_Journal>(METADATA_PATH + "update.journal");
+        if (resume) return Resume_Update();
+
         std::cout << "Performing upgrades!\n";
         if (Update_PKGs(Check_For_Updates(), no_syu)) return ERR_CODE;
         return SUCCESS_CODE;
     }
 
 
+    // ? Keeps a bare mirror of the package's repository and checks it out into a disposable worktree,
+    // ? so rebuilding a package only fetches the commits since its last build
     int32_t Clone_AUR_PKG(const std::string &pkg_query)
     {
-        std::cout << "Cloning package!\n";
-        if (!Does_Install_Dir_Exists()) std::filesystem::create_directory(INSTALL_PATH);
+        std::error_code error;
+        std::filesystem::create_directories(MIRROR_PATH, error);
+
+        const std::string mirror_path = MIRROR_PATH + pkg_query + ".git";
+        std::vector<std::string> command;
+        if (std::filesystem::exists(mirror_path + "/HEAD")) command = { "git", "-C", mirror_path, "fetch", "--quiet", "--prune" };
+        else {
+            // ? A half written mirror of an interrupted clone is useless
+            std::filesystem::remove_all(mirror_path, error);
+            command = { "git", "clone", "--quiet", "--mirror", AUR_Client().Base_URL() + "/" + pkg_query + ".git", mirror_path };
+        }
+        if (Run_Command(command, INSTALL_PATH)) {
+            std::cerr << WARNING_COLOUR << "Failed to clone AUR package!\n" << RESET;
+            return ERR_CODE;
+        }
+
+        // ? Leftovers of an earlier failed build would make git refuse the checkout
+        std::filesystem::remove_all(INSTALL_PATH + pkg_query, error);
+        if (Run_Command({ "git", "-C", mirror_path, "worktree", "prune" }, INSTALL_PATH)
+            || Run_Command({ "git", "-C", mirror_path, "worktree", "add", "--quiet", "--force", "--detach", INSTALL_PATH + pkg_query, "HEAD" }, INSTALL_PATH)) {
+            std::cerr << WARNING_COLOUR << "Failed to check out AUR package!\n" << RESET;
+            return ERR_CODE;
+        }
+        return SUCCESS_CODE;
+    }
+
+
+    // ? Fetches every base as a cgit snapshot over the shared client, the archives are extracted while they download.
+    // ? No git process, history or .git directory, which suits one-shot builds
+    int32_t Download_AUR_Snapshots(const std::vector<Build_Node> &nodes)
+    {
+        std::cout << "Downloading package snapshots!\n";
+        RPC_Client &client = AUR_Client();
+        std::vector<std::unique_ptr<Tar_Stream>> extractors;
+        bool success = true;
+
+        for (const auto &node : nodes) {
+            const std::string package_path = INSTALL_PATH + node.package_base;
+            std::error_code error;
+            std::filesystem::remove_all(package_path, error);
+            std::filesystem::create_directories(package_path, error);
+
+            extractors.push_back(std::make_unique<Tar_Stream>(package_path));
+            Tar_Stream *extractor = extractors.back().get();
+            const std::string &package_base = node.package_base;
+            client.Queue(client.Base_URL() + "/cgit/aur.git/snapshot/" + client.Escape(package_base) + ".tar.gz",
+                [extractor](const char *data, std::size_t size) { return extractor->Feed(data, size); },
+                [extractor, &package_base, &success](bool done, long) {
+                    if (done && extractor->Is_Complete()) return;
+                    std::cerr << WARNING_COLOUR << "Failed to download snapshot of " << package_base;
+                    if (!extractor->Error().empty()) std::cerr << ": " << extractor->Error();
+                    std::cerr << '\n' << RESET;
+                    success = false;
+                });
+        }
+
+        client.Perform();
+        return success ? SUCCESS_CODE : ERR_CODE;
+    }
 
-        std::filesystem::current_path(INSTALL_PATH);
-        std::string command = "git clone https://aur.archlinux.org/" + pkg_query + ".git " + INSTALL_PATH + pkg_query;
 
-        if (std::system(command.c_str())) {
-            std::cerr << WARNING_COLOUR << "Failed to clone AUR package!\n";
+    // ? Runs on a fetch thread while other packages build, so its output goes to the log directory
+    int32_t Fetch_PKG(const Build_Node &node)
+    {
+        if (!use_tarballs && Clone_AUR_PKG(node.package_base)) return ERR_CODE;
+
+        // ? A cached build needs none of the upstream sources, which may be gone for an older version anyway
+        const std::string package_path = INSTALL_PATH + node.package_base;
+        const std::string input_hash = Artifact_Input_Hash(package_path);
+        std::vector<std::string> pkg_files;
+        if (!input_hash.empty() && artifact_cache.Find(input_hash, pkg_files)) return SUCCESS_CODE;
+        // ? Then another machine may have built it already, the build step finds it in the artifact cache
+        if (!input_hash.empty() && substituter && substituter->Has_Sources() && substituter->Fetch(input_hash, node.version, pkg_files)) {
+            std::cout << "Downloaded a prebuilt " + node.package_base + "\n";
+            return SUCCESS_CODE;
+        }
+
+        // ? makepkg only downloads what the source cache could not provide
+        source_cache.Materialize(package_path);
+
+        std::error_code error;
+        std::filesystem::create_directories(LOG_PATH, error);
+        if (Run_Command({ "makepkg", "--verifysource", "--nodeps", "--noconfirm" }, package_path, LOG_PATH + node.package_base + ".fetch.log")) {
+            std::cerr << WARNING_COLOUR << "Failed to download the sources of " << node.package_base << "!\n" << RESET;
             return ERR_CODE;
         }
+        source_cache.Store(package_path);
         return SUCCESS_CODE;
     }
 
 
-    int32_t Build_And_Install_PKG(const std::string &pkg_query)
+    // ? Runs on a scheduler worker, so it prints whole lines only and reads the installed set under its lock
+    int32_t Build_PKG(const Build_Node &node, std::vector<std::string> &pkg_files)
     {
-        std::cout << "Building package!\n";
-        const std::filesystem::path package_path = INSTALL_PATH + pkg_query;
+        const std::string package_path = INSTALL_PATH + node.package_base;
+        if (!std::filesystem::exists(package_path)) return ERR_CODE;
+
+        // ? Concurrent builds would interleave on the terminal, so each one gets a log file instead
+        std::string log_file;
+        if (build_jobs > 1) {
+            std::error_code error;
+            std::filesystem::create_directories(LOG_PATH, error);
+            log_file = LOG_PATH + node.package_base + ".log";
+        }
 
-        if (!std::filesystem::exists(package_path)) {
-            std::cerr << WARNING_COLOUR <<  "PKG directory does not exist: " << package_path << "\n";
+        // ? Identical inputs build identical packages, so those come straight out of the artifact cache,
+        // ? substitutes included, Fetch_PKG() imported them there
+        const std::string input_hash = Artifact_Input_Hash(package_path);
+        if (!input_hash.empty() && artifact_cache.Find(input_hash, pkg_files)) {
+            std::cout << "Reusing cached build of " + node.package_base + "\n";
+            artifact_cache_hits++;
+            return SUCCESS_CODE;
+        }
+
+        // ? Built as the user only, installing is left to Install_Built_PKGs()
+        artifact_cache_misses++;
+        Process_Usage usage;
+        std::vector<std::string> command = { "makepkg", "-cf", "--noconfirm" };
+        if (build_cgroups) command = build_cgroups->Wrap(command);
+        if (Run_Command(command, package_path, log_file, jobserver ? jobserver->Environment() : std::vector<std::string>(), &usage,
+                jobserver ? jobserver->Inherited_Fds() : std::vector<int>())) {
             return ERR_CODE;
         }
+        history.Record(node.package_base, node.version, usage);
+
+        pkg_files = Get_Built_PKGs(node);
+        if (pkg_files.empty()) return ERR_CODE;
+        if (!input_hash.empty()) artifact_cache.Store(input_hash, node.version, pkg_files);
+        return SUCCESS_CODE;
+    }
 
-        std::filesystem::current_path(package_path);
-        if (std::system("makepkg -risc")) {
-            std::cerr << WARNING_COLOUR <<  "Failed to build package!\n";
+
+    // ? Dependencies built by the plan count with the version they get, the rest with the installed one
+    std::string Artifact_Input_Hash(const std::string &package_path)
+    {
+        Srcinfo fields;
+        if (!Read_Srcinfo(package_path + "/.SRCINFO", fields)) return "";
+
+        std::vector<std::string> resolved_dependencies;
+        std::lock_guard<std::mutex> lock(installed_mutex);
+        installed.Load();
+        for (const auto &dependency : Build_Dependencies(fields)) {
+            Dependency dep = Parse_Dependency(dependency);
+            auto planned = planned_versions.find(dep.name);
+            if (planned != planned_versions.end()) {
+                resolved_dependencies.push_back(dependency + " " + planned->second);
+                continue;
+            }
+            const Installed_PKG *pkg = installed.Find(dep.name);
+            resolved_dependencies.push_back(dependency + " " + (pkg ? pkg->version : installed.Satisfies(dep) ? "provided" : "missing"));
+        }
+        return artifact_cache.Input_Hash(package_path, resolved_dependencies);
+    }
+
+
+    // ? Package files makepkg produced for node, without the -debug packages
+    std::vector<std::string> Get_Built_PKGs(const Build_Node &node)
+    {
+        std::vector<std::string> pkg_files;
+        std::string output;
+        if (!Read_Command({ "makepkg", "--packagelist" }, INSTALL_PATH + node.package_base, output)) return pkg_files;
+
+        std::istringstream lines(output);
+        std::string pkg_file;
+        std::regex debug_pkg(".*-debug-[^-]+-[^-]+-[^-]+\\.pkg\\.tar.*");
+        while (std::getline(lines, pkg_file)) {
+            if (std::regex_match(pkg_file, debug_pkg) || !std::filesystem::exists(pkg_file)) continue;
+            pkg_files.push_back(pkg_file);
+        }
+        return pkg_files;
+    }
+
+
+    // ? Installs a whole batch in one pacman transaction, two if it mixes targets and dependencies
+    int32_t Install_Built_PKGs(const std::vector<Built_Node> &built)
+    {
+        std::vector<std::string> explicit_files;
+        std::vector<std::string> dependency_files;
+        for (const auto &built_node : built) {
+            std::vector<std::string> &files = built_node.node->is_dependency ? dependency_files : explicit_files;
+            files.insert(files.end(), built_node.pkg_files.begin(), built_node.pkg_files.end());
+        }
+
+        if (!local_repo_dir.empty() && Add_To_Local_Repo(built)) return ERR_CODE;
+
+        std::cout << "Installing " << built.size() << (built.size() == 1 ? " package base" : " package bases") << "...\n";
+        auto Pacman_Install = [](const std::vector<std::string> &pkg_files, bool as_dependencies) {
+            std::vector<std::string> command = { "sudo", "pacman", "-U" };
+            if (as_dependencies) command.push_back("--asdeps");
+            command.insert(command.end(), pkg_files.begin(), pkg_files.end());
+            return Run_Command(command);
+        };
+        if ((!dependency_files.empty() && Pacman_Install(dependency_files, true)) || (!explicit_files.empty() && Pacman_Install(explicit_files, false))) {
+            std::cerr << WARNING_COLOUR << "Failed to install package!\n" << RESET;
+            return ERR_CODE;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(installed_mutex);
+            Installed_Changed();
+        }
+        std::cout << "Cleaning directories...\n";
+        for (const auto &built_node : built) Clean(built_node.node->package_base);
+        return SUCCESS_CODE;
+    }
+
+    // ? Other machines use the directory as a [hone] repository, so one builder serves all of them
+    int32_t Add_To_Local_Repo(const std::vector<Built_Node> &built)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(local_repo_dir, error);
+        if (error) {
+            std::cerr << WARNING_COLOUR << "Failed to create " << local_repo_dir << ": " << error.message() << '\n' << RESET;
             return ERR_CODE;
         }
 
-        std::cout << "Successfully build package!\nCleaning directory...\n";
-        Clean(pkg_query);
+        // ? --remove drops the files of the versions these replace, the repository only keeps the latest
+        const std::string database = local_repo_dir + "/" + LOCAL_REPO_NAME + ".db.tar.gz";
+        std::vector<std::string> command = { "repo-add", "--quiet", "--remove", database };
+        for (const auto &built_node : built) {
+            for (const auto &pkg_file : built_node.pkg_files) {
+                const std::string file_name = std::filesystem::path(pkg_file).filename().string();
+                const std::string repo_file = local_repo_dir + "/" + file_name;
+                if (!std::filesystem::exists(repo_file) && !Link_File(pkg_file, repo_file)) {
+                    std::cerr << WARNING_COLOUR << "Failed to copy " << file_name << " into the local repository!\n" << RESET;
+                    return ERR_CODE;
+                }
+                if (std::filesystem::exists(pkg_file + ".sig") && !std::filesystem::exists(repo_file + ".sig")) Link_File(pkg_file + ".sig", repo_file + ".sig");
+                command.push_back(repo_file);
+            }
+        }
 
-        std::filesystem::current_path(HOME_DIR);
+        if (Run_Command(command)) {
+            std::cerr << WARNING_COLOUR << "Failed to add packages to " << database << "!\n" << RESET;
+            return ERR_CODE;
+        }
         return SUCCESS_CODE;
     }
 
+
     // * Clean the package directory
     void Clean(const std::string &pkg_query)
     {
-        std::filesystem::current_path(INSTALL_PATH);
-        std::filesystem::remove_all(pkg_query);
+        std::error_code error;
+        std::filesystem::remove_all(INSTALL_PATH + pkg_query, error);
+    }
+
+
+    void Print_Cache_Report()
+    {
+        const std::size_t substitute_hits = substituter ? substituter->Hits() : 0;
+        if (artifact_cache_hits == 0 && (!substituter || !substituter->Has_Sources())) return;
+
+        std::cout << "Build cache: " << artifact_cache_hits << " hits (" << (artifact_cache_hits > substitute_hits ? artifact_cache_hits - substitute_hits : 0) << " local, "
+                  << substitute_hits << " substituted), " << artifact_cache_misses << " misses\n";
+    }
+
+
+    // ? Sources of a resumed update are only fetched again when their build directory is gone
+    bool Resumed_Fetch(const Build_Node &node)
+    {
+        if (!journal) return false;
+        std::vector<std::string> pkg_files;
+        if (journal->Built_Files(node.package_base, pkg_files)) return true;
+        return journal->State(node.package_base) == Journal_State::Fetched && std::filesystem::exists(INSTALL_PATH + node.package_base);
+    }
+
+
+    bool Resumed_Build(const Build_Node &node, std::vector<std::string> &pkg_files)
+    {
+        if (!journal || !journal->Built_Files(node.package_base, pkg_files)) return false;
+        std::cout << "Reusing the build of " + node.package_base + " from the unfinished update\n";
+        return true;
+    }
+
+
+    int32_t Execute_Build_Plan(const Build_Plan &full_plan)
+    {
+        // ? A resumed update leaves out whatever got installed before it stopped
+        Build_Plan plan = full_plan;
+        if (journal) {
+            plan.nodes.erase(std::remove_if(plan.nodes.begin(), plan.nodes.end(), [this](const Build_Node &node) {
+                return journal->State(node.package_base) == Journal_State::Installed;
+            }), plan.nodes.end());
+        }
+
+        // ? makepkg runs without -s, so every repository dependency is installed up front in one go
+        std::vector<std::string> repo_pkgs = plan.repo_depends;
+        repo_pkgs.insert(repo_pkgs.end(), plan.repo_make_depends.begin(), plan.repo_make_depends.end());
+        if (!repo_pkgs.empty()) {
+            std::vector<std::string> command = { "sudo", "pacman", "-S", "--needed", "--asdeps" };
+            command.insert(command.end(), repo_pkgs.begin(), repo_pkgs.end());
+            if (Run_Command(command)) {
+                std::cerr << WARNING_COLOUR << "Failed to install repository dependencies!\n" << RESET;
+                return ERR_CODE;
+            }
+        }
+
+        // ? Snapshots share one connection pool and come down together, git clones are left to the fetch threads.
+        // ? Extracting wipes the build directory, so bases a resumed update already fetched or built keep theirs
+        if (use_tarballs) {
+            std::vector<Build_Node> snapshot_nodes;
+            for (const auto &node : plan.nodes) {
+                if (!Resumed_Fetch(node)) snapshot_nodes.push_back(node);
+            }
+            if (!snapshot_nodes.empty() && Download_AUR_Snapshots(snapshot_nodes)) return ERR_CODE;
+        }
+
+        // ? A MAKEFLAGS set in makepkg.conf still wins, makepkg reads it after the environment
+        if (build_jobs > 1) jobserver = std::make_unique<Jobserver>(std::max<std::size_t>(std::thread::hardware_concurrency(), 1), build_jobs);
+
+        planned_versions.clear();
+        for (const auto &node : plan.nodes) {
+            for (const auto &pkg_name : node.pkg_names) planned_versions[pkg_name] = node.version;
+        }
+
+        history.Load();
+        // ? Leaves a tenth of the free memory to the rest of the system
+        const long memory_budget_kb = Available_Memory_KB() / 10 * 9;
+        if (build_jobs > 1) build_cgroups = std::make_unique<Build_Cgroups>(memory_budget_kb);
+        std::cout << "Fetching " << plan.nodes.size() << " package sources in the background...\n";
+        // ? Every step of an update leaves its outcome in the journal, failures included
+        auto Journal = [this](const Build_Node &node, bool success, Journal_State state, const std::vector<std::string> &pkg_files) {
+            if (journal) journal->Record(node.package_base, success ? state : Journal_State::Failed, pkg_files);
+            return success;
+        };
+        Build_Scheduler scheduler(build_jobs, FETCH_JOBS,
+            [this, Journal](const Build_Node &node) {
+                return Resumed_Fetch(node) || Journal(node, Fetch_PKG(node) == SUCCESS_CODE, Journal_State::Fetched, {});
+            },
+            [this, Journal](const Build_Node &node, std::vector<std::string> &pkg_files) {
+                return Resumed_Build(node, pkg_files) || Journal(node, Build_PKG(node, pkg_files) == SUCCESS_CODE, Journal_State::Built, pkg_files);
+            },
+            [this, Journal](const std::vector<Built_Node> &built) {
+                if (Install_Built_PKGs(built)) return false;
+                for (const auto &built_node : built) Journal(*built_node.node, true, Journal_State::Installed, {});
+                return true;
+            },
+            [this](const Build_Node &node) { return history.Wall_Seconds(node.package_base); });
+        if (memory_budget_kb > 0) {
+            scheduler.Limit_Memory(memory_budget_kb, [this](const Build_Node &node) {
+                long peak_rss_kb = history.Peak_RSS_KB(node.package_base);
+                return peak_rss_kb > 0 ? peak_rss_kb : DEFAULT_BUILD_MEMORY_KB;
+            });
+        }
+        const bool success = scheduler.Run(plan);
+        jobserver.reset();
+        build_cgroups.reset();
+        source_cache.Evict();
+        Print_Cache_Report();
+        if (!success) {
+            if (build_jobs > 1) std::cerr << "Build logs are in " << LOG_PATH << '\n';
+            return ERR_CODE;
+        }
+
+        // ? Same as makepkg -r, build time dependencies do not stay around
+        if (!plan.repo_make_depends.empty()) {
+            std::vector<std::string> command = { "sudo", "pacman", "-Rns" };
+            command.insert(command.end(), plan.repo_make_depends.begin(), plan.repo_make_depends.end());
+            Run_Command(command);
+            Installed_Changed();
+        }
+        return SUCCESS_CODE;
+    }
+
+
+    // ? Installed package changes drop the result, otherwise it is worked out once per run
+    void Installed_Changed()
+    {
+        installed.Invalidate();
+        session.Installed_Changed();
     }
 
 
     std::vector<std::string> Check_For_Updates()
     {
+        if (session.updates) return *session.updates;
+
         std::vector<std::string> pkgs_to_update;
-        std::vector<std::string> pkg_list = Get_PKG_List();
+        installed.Load();
+        std::vector<Installed_PKG> pkg_list = installed.Foreign();
 
-        if (pkg_list.empty()) return pkgs_to_update;
+        if (pkg_list.empty()) {
+            session.updates = pkgs_to_update;
+            return pkgs_to_update;
+        }
 
+        // ? Collect every foreign package first, so the AUR can be queried in batches
+        std::regex end_with_debug(".*-debug$");
+        std::vector<Installed_PKG> installed_pkgs;
+        std::vector<std::string> pkg_names;
         for (const auto &pkg : pkg_list) {
-            std::regex end_with_debug(".*-debug$");
-            std::istringstream iss(pkg);
-            std::string pkg_version;
-            std::string pkg_name;
-            iss >> pkg_name >> pkg_version;
+            if (std::regex_match(pkg.name, end_with_debug)) continue;
+            installed_pkgs.push_back(pkg);
+            pkg_names.push_back(pkg.name);
+        }
 
-            if (std::regex_match(pkg_name, end_with_debug)) continue;
+        PKG_Info_Map pkg_infos;
+        if (!Get_PKG_Infos(pkg_names, pkg_infos)) {
+            std::cerr << WARNING_COLOUR << "Some update checks failed!\n" << RESET;
+        }
 
-            std::string current_version = Get_PKG_Version(pkg_name);
-            if (current_version == "Not found") {
-                std::cerr << WARNING_COLOUR << "PKG " << pkg_name << " not found in the AUR!\n" << RESET;
+        for (const auto &pkg : installed_pkgs) {
+            auto info = pkg_infos.find(pkg.name);
+            if (info == pkg_infos.end()) {
+                std::cerr << WARNING_COLOUR << "PKG " << pkg.name << " not found in the AUR!\n" << RESET;
                 continue;
             }
 
-            if (current_version != pkg_version) pkgs_to_update.push_back(pkg_name);
+            // ? Only a strictly newer AUR version is an update, never a downgrade or a different spelling
+            if (Vercmp(info->second.version, pkg.version) > 0) pkgs_to_update.push_back(pkg.name);
         }
 
+        session.updates = pkgs_to_update;
         return pkgs_to_update;
     }
 
@@ -305,48 +684,117 @@ private:
     {
         // ? Perform system update to avoid depedencies mismatch
         if (!no_syu) {
-            if (std::system("sudo pacman -Syu")) {
+            if (Run_Command({ "sudo", "pacman", "-Syu" })) {
                 std::cerr << "System update failed, please do pacman -Syu manually!\n";
                 return ERR_CODE;
             }
+            Installed_Changed();
         }
 
-        // ? Update AUR packages
-        std::vector<std::string> updated_packages;
-        for (const auto &pkg_name : packages_to_update) {
-            std::cout << "Updating AUR packages!\n";
-            if (!Install_AUR_PKG(pkg_name)) {
-                std::cerr << "Failed to update package: " << pkg_name << '\n';
-                return ERR_CODE;
-            }
-            updated_packages.push_back(pkg_name);
+        if (packages_to_update.empty()) {
+            std::cout << "No AUR packages to update.\n";
+            return SUCCESS_CODE;
         }
 
+        // ? Update AUR packages, all of them share one plan so independent ones can build together
+        std::cout << "Updating AUR packages!\n";
+        Build_Plan plan;
+        if (Resolve_Build_Plan(packages_to_update, plan)) {
+            std::cerr << "Failed to update packages!\n";
+            return ERR_CODE;
+        }
+        if (!journal->Begin(packages_to_update, plan)) std::cerr << WARNING_COLOUR << "Failed to write the update journal, --resume will not work!\n" << RESET;
+        return Run_Update(packages_to_update, plan);
+    }
+
+
+    // ? Goes on with the plan of the last unfinished -U, without the system upgrade and the update check
+    int32_t Resume_Update()
+    {
+        std::vector<std::string> packages_to_update;
+        Build_Plan plan;
+        if (!journal->Load(packages_to_update, plan)) {
+            std::cerr << "No unfinished update to resume.\n";
+            return ERR_CODE;
+        }
+
+        std::cout << "Resuming the update of " << plan.nodes.size() << (plan.nodes.size() == 1 ? " package base" : " package bases") << "!\n";
+        return Run_Update(packages_to_update, plan);
+    }
+
+
+    int32_t Run_Update(const std::vector<std::string> &packages_to_update, const Build_Plan &plan)
+    {
+        if (Execute_Build_Plan(plan)) {
+            std::cerr << "Failed to update packages! Run hone -U --resume to go on from here.\n";
+            return ERR_CODE;
+        }
+        journal->Finish();
+
         std::cout << "Successfully updated: ";
-        for (const auto &pkg_name : updated_packages) std::cout << NAME_COLOUR << pkg_name << ' ';
+        for (const auto &pkg_name : packages_to_update) std::cout << NAME_COLOUR << pkg_name << ' ';
+        std::cout << RESET << '\n';
+        return SUCCESS_CODE;
+    }
+
+
+    int32_t Resolve_Build_Plan(const std::vector<std::string> &targets, Build_Plan &plan)
+    {
+        std::cout << "Resolving dependencies...\n";
+        if (const Build_Plan *known_plan = session.Plan_For(targets)) plan = *known_plan;
+        else {
+            if (!installed.Load() || !sync_db.Load()) return ERR_CODE;
+
+            Dependency_Resolver resolver(installed, sync_db, [this](const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos) {
+                return Get_PKG_Infos(pkg_names, pkg_infos);
+            });
+            if (!resolver.Resolve(targets, plan)) return ERR_CODE;
+            session.Remember_Plan(targets, plan);
+        }
+
+        if (!plan.repo_depends.empty()) {
+            std::cout << "Repository dependencies:";
+            for (const auto &pkg_name : plan.repo_depends) std::cout << ' ' << pkg_name;
+            std::cout << '\n';
+        }
+
+        std::cout << "Build order:";
+        for (const auto &node : plan.nodes) std::cout << ' ' << NAME_COLOUR << node.package_base << ' ' << VERSION_COLOUR << node.version << RESET;
         std::cout << '\n';
         return SUCCESS_CODE;
     }
 
 
-    int32_t Install_AUR_PKG(const std::string &pkg_query)
+    // ? All targets share one plan, so common dependencies and split package bases are built once
+    int32_t Install_AUR_PKG(const std::vector<std::string> &pkg_queries)
     {
         if (!Check_For_Updates().empty()) std::cout << WARNING_COLOUR << "WARNING: " << RESET << "You have updates due!\n";
-        if (Clone_AUR_PKG(pkg_query)) return ERR_CODE;
-        if (Build_And_Install_PKG(pkg_query)) return ERR_CODE;
-        return SUCCESS_CODE;
+
+        // ? The whole plan is known before anything gets cloned, so a missing dependency fails early
+        Build_Plan plan;
+        if (Resolve_Build_Plan(pkg_queries, plan)) return ERR_CODE;
+        return Execute_Build_Plan(plan);
     }
 
 
-    int32_t Remove_Installed_PKG(const std::string &pkg_query)
+    int32_t Remove_Installed_PKG(const std::vector<std::string> &pkg_queries)
     {
-        if (!Is_PKG_Installed(pkg_query)) {
-            std::cerr << WARNING_COLOUR << "Package " << pkg_query << " not installed." << RESET << '\n';
+        installed.Load();
+
+        // ? pacman refuses the whole transaction over one unknown target, so those are left out
+        std::vector<std::string> command = { "sudo", "pacman", "-Rns" };
+        for (const auto &pkg_query : pkg_queries) {
+            if (!installed.Contains(pkg_query)) {
+                std::cerr << WARNING_COLOUR << "Package " << pkg_query << " not installed." << RESET << '\n';
+                continue;
+            }
+            command.push_back(pkg_query);
         }
+        if (command.size() == 3) return ERR_CODE;
 
-        const std::string command = "sudo pacman -Rns " + pkg_query;
-        if (system(command.c_str())) return 1;
-        return 0;
+        if (Run_Command(command)) return ERR_CODE;
+        Installed_Changed();
+        return SUCCESS_CODE;
     }
 };
 
@@ -355,24 +803,36 @@ int32_t main(int32_t argc, char **argv)
 {
     CLI::App app{"AUR Helper Only"};
 
-    std::string install_query;
-    std::string remove_query;
+    std::vector<std::string> install_query;
+    std::vector<std::string> remove_query;
     std::string search_query;
     bool only_name = false;
     bool is_list = false;
     bool no_syu = false;
+    bool refresh = false;
+    bool tarball = false;
     bool update = false;
+    bool resume = false;
+    std::size_t jobs = 1;
+    std::string repo_dir;
+    std::vector<std::string> substitutes;
 
-    app.add_option("-S,--Sync", install_query, "Download packages");
+    app.add_option("-S,--Sync", install_query, "Download packages, several can be given at once");
     app.add_option("-s,--search", search_query, "Search for packages");
     app.add_flag("-n,--name", only_name, "Only list pkg's names. Use only with the --search option");
     app.add_flag("-U,--update", update, "Upgrade AUR packages, aswell upgrades the system");
     app.add_flag("--no-sysupgrade", no_syu, "Prevents the code to run pacman -Syu");
+    app.add_flag("--resume", resume, "Continue the last update that failed or got interrupted. Use only with the --update option");
     app.add_flag("-Q,--query", is_list, "List installed AUR packages");
-    app.add_option("-R,--Remove", remove_query, "Removes a package");
+    app.add_option("-R,--Remove", remove_query, "Removes packages");
+    app.add_option("-j,--jobs", jobs, "Number of packages built at the same time");
+    app.add_flag("--tarball", tarball, "Download snapshot tarballs instead of keeping git mirrors of the packages");
+    app.add_option("--repo", repo_dir, "Also add every built package to a pacman repository named hone in this directory");
+    app.add_option("--substitute", substitutes, "Look for signed prebuilt packages in this artifact cache (directory or http(s) url) before building");
+    app.add_flag("--refresh", refresh, "Download the AUR metadata snapshot used for offline search and update checks");
 
     CLI11_PARSE(app, argc, argv);
 
     AUR_Helper Hone;
-    return Hone.Start(install_query, remove_query, search_query, only_name, is_list, update, no_syu);
+    return Hone.Start(install_query, remove_query, search_query, only_name, is_list, update, no_syu, refresh, tarball, jobs, repo_dir, substitutes, resume);
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "../include/installed_store.hpp"
+#include "../include/local_db.hpp"
+#include <algorithm>
+
+
+Installed_Store::Installed_Store(const std::string &db_path, const std::string &cache_file)
+    : db_path(db_path), cache_file(cache_file)
+{
+}
+
+
+bool Installed_Store::Load()
+{
+    if (loaded) return true;
+
+    std::vector<Installed_PKG> pkg_list;
+    Local_DB local_db(db_path, cache_file);
+    if (!local_db.Read(pkg_list)) return false;
+
+    for (auto &pkg : pkg_list) {
+        provides.Add(pkg.name, pkg.version, pkg.provides);
+        std::string pkg_name = pkg.name;
+        pkgs[pkg_name] = std::move(pkg);
+    }
+
+    loaded = true;
+    return true;
+}
+
+
+void Installed_Store::Invalidate()
+{
+    pkgs.clear();
+    provides.Clear();
+    loaded = false;
+}
+
+
+bool Installed_Store::Contains(const std::string &pkg_name) const
+{
+    return pkgs.count(pkg_name) > 0;
+}
+
+
+const Installed_PKG *Installed_Store::Find(const std::string &pkg_name) const
+{
+    auto pkg = pkgs.find(pkg_name);
+    return pkg != pkgs.end() ? &pkg->second : nullptr;
+}
+
+
+std::vector<Installed_PKG> Installed_Store::Foreign() const
+{
+    std::vector<Installed_PKG> foreign_pkgs;
+    for (const auto &[pkg_name, pkg] : pkgs) {
+        if (pkg.foreign) foreign_pkgs.push_back(pkg);
+    }
+
+    std::sort(foreign_pkgs.begin(), foreign_pkgs.end(), [](const Installed_PKG &a, const Installed_PKG &b) { return a.name < b.name; });
+    return foreign_pkgs;
+}
@@ -0,0 +1,73 @@
+#include "../include/jobserver.hpp"
+#include "../include/command.hpp"
+#include <sys/stat.h>
+#include <filesystem>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+
+
+// ? fifo: jobservers need GNU make 4.4, older ones reject MAKEFLAGS that use them
+static bool Make_Supports_Fifo()
+{
+    std::string version;
+    if (!Read_Command({ "make", "--version" }, "", version)) return true;
+
+    int major = 0;
+    int minor = 0;
+    if (std::sscanf(version.c_str(), "GNU Make %d.%d", &major, &minor) != 2) return true;
+    return major > 4 || (major == 4 && minor >= 4);
+}
+
+
+Jobserver::Jobserver(std::size_t slots, std::size_t clients)
+    : slots(slots ? slots : 1)
+{
+    std::error_code error;
+    std::filesystem::path tmp_dir = std::filesystem::temp_directory_path(error);
+    if (error) return;
+
+    fifo_path = (tmp_dir / ("hone-jobserver." + std::to_string(getpid()))).string();
+    unlink(fifo_path.c_str());
+    if (mkfifo(fifo_path.c_str(), 0600)) return;
+
+    fifo_fd = open(fifo_path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fifo_fd < 0) {
+        unlink(fifo_path.c_str());
+        return;
+    }
+
+    // ? With more clients than slots, each build still gets its one implicit job
+    const std::string tokens(this->slots > clients ? this->slots - clients : 0, '+');
+    if ((!tokens.empty() && write(fifo_fd, tokens.data(), tokens.size()) != static_cast<ssize_t>(tokens.size()))
+        || (!Make_Supports_Fifo() && (inherited_fd = open(fifo_path.c_str(), O_RDWR | O_CLOEXEC)) < 0)) {
+        close(fifo_fd);
+        fifo_fd = -1;
+        unlink(fifo_path.c_str());
+    }
+}
+
+
+Jobserver::~Jobserver()
+{
+    if (inherited_fd >= 0) close(inherited_fd);
+    if (fifo_fd < 0) return;
+    close(fifo_fd);
+    unlink(fifo_path.c_str());
+}
+
+
+std::vector<std::string> Jobserver::Environment() const
+{
+    if (fifo_fd < 0) return {};
+    // ? One descriptor open for reading and writing serves as both ends of the old pipe form
+    const std::string auth = inherited_fd >= 0 ? std::to_string(inherited_fd) + "," + std::to_string(inherited_fd) : "fifo:" + fifo_path;
+    return { "MAKEFLAGS=-j" + std::to_string(slots) + " --jobserver-auth=" + auth };
+}
+
+
+std::vector<int> Jobserver::Inherited_Fds() const
+{
+    if (fifo_fd < 0 || inherited_fd < 0) return {};
+    return { inherited_fd };
+}
@@ -0,0 +1,165 @@
+#include "../include/json_stream.hpp"
+
+using json = nlohmann::json;
+
+
+PKG_Info_SAX::PKG_Info_SAX(int32_t record_depth, PKG_Info_Callback on_record)
+    : record_depth(record_depth), on_record(std::move(on_record))
+{
+}
+
+
+bool PKG_Info_SAX::start_object(std::size_t)
+{
+    if (++depth == record_depth) current = PKG_Info{};
+    return true;
+}
+
+
+bool PKG_Info_SAX::end_object()
+{
+    if (depth-- == record_depth && !current.name.empty()) {
+        if (current.package_base.empty()) current.package_base = current.name;
+        on_record(std::move(current));
+    }
+    return true;
+}
+
+
+bool PKG_Info_SAX::start_array(std::size_t)
+{
+    depth++;
+    return true;
+}
+
+
+bool PKG_Info_SAX::end_array()
+{
+    depth--;
+    return true;
+}
+
+
+bool PKG_Info_SAX::key(string_t &value)
+{
+    if (depth == record_depth) current_key = value;
+    return true;
+}
+
+
+bool PKG_Info_SAX::parse_error(std::size_t, const std::string &, const nlohmann::detail::exception &exception)
+{
+    error = exception.what();
+    return false;
+}
+
+
+std::vector<std::string> *PKG_Info_SAX::List(const std::string &key)
+{
+    if (key == "Depends") return &current.depends;
+    if (key == "MakeDepends") return &current.make_depends;
+    if (key == "CheckDepends") return &current.check_depends;
+    return nullptr;
+}
+
+
+bool PKG_Info_SAX::Value(const std::string &value)
+{
+    // ? Elements of the dependency arrays sit one level below the record
+    if (depth == record_depth + 1) {
+        auto *list = List(current_key);
+        if (list) list->push_back(value);
+        return true;
+    }
+
+    if (depth != record_depth) return true;
+    if (current_key == "Name") current.name = value;
+    else if (current_key == "PackageBase") current.package_base = value;
+    else if (current_key == "Version") current.version = value;
+    else if (current_key == "Description") current.description = value;
+    return true;
+}
+
+
+Result_Stream::Result_Stream(PKG_Info_Callback on_result)
+    : result_parser(1, std::move(on_result))
+{
+}
+
+
+// ? Top level strings alternate between keys and values, only "error" values are of interest
+void Result_Stream::On_Top_Level_String()
+{
+    if (expect_key) last_key = top_level_string;
+    else if (last_key == "error") error = top_level_string;
+}
+
+
+bool Result_Stream::Emit_Result()
+{
+    if (!json::sax_parse(result_buffer, &result_parser)) {
+        error = result_parser.Error();
+        return false;
+    }
+    return true;
+}
+
+
+bool Result_Stream::Feed(const char *data, std::size_t size)
+{
+    if (!valid) return false;
+
+    for (std::size_t i = 0; i < size; i++) {
+        const char c = data[i];
+        if (capturing) result_buffer.push_back(c);
+
+        if (in_string) {
+            if (escaped) escaped = false;
+            else if (c == '\\') escaped = true;
+            else if (c == '"') {
+                in_string = false;
+                if (depth == 1) On_Top_Level_String();
+                continue;
+            }
+            if (depth == 1) top_level_string.push_back(c);
+            continue;
+        }
+
+        switch (c) {
+        case '"':
+            in_string = true;
+            top_level_string.clear();
+            break;
+        case '{':
+        case '[':
+            if (++depth == 1) {
+                seen_document = true;
+                expect_key = true;
+            }
+            if (c == '[' && depth == 2 && last_key == "results") in_results = true;
+            if (c == '{' && depth == 3 && in_results) {
+                capturing = true;
+                result_buffer.assign(1, '{');
+            }
+            break;
+        case '}':
+        case ']':
+            if (c == '}' && depth == 3 && capturing) {
+                capturing = false;
+                if (!Emit_Result()) valid = false;
+            }
+            if (c == ']' && depth == 2) in_results = false;
+            if (--depth < 0) valid = false;
+            break;
+        case ':':
+            if (depth == 1) expect_key = false;
+            break;
+        case ',':
+            if (depth == 1) expect_key = true;
+            break;
+        }
+
+        if (!valid) return false;
+    }
+    return true;
+}
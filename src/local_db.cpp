@@ -0,0 +1,225 @@
+#include "../include/colours.hpp"
+#include "../include/local_db.hpp"
+#include <archive_entry.h>
+#include <archive.h>
+#include <sys/stat.h>
+#include <string_view>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const std::string CACHE_MAGIC = "HONELOCAL 2";
+
+
+Local_DB::Local_DB(const std::string &db_path, const std::string &cache_file)
+    : db_path(!db_path.empty() && db_path.back() != '/' ? db_path + '/' : db_path), cache_file(cache_file)
+{
+}
+
+
+static std::string File_Stamp(const std::string &path)
+{
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat)) return "-";
+    return std::to_string(file_stat.st_mtim.tv_sec) + '.' + std::to_string(file_stat.st_mtim.tv_nsec) + ':' + std::to_string(file_stat.st_size);
+}
+
+
+std::vector<std::string> Sync_DBs(const std::string &db_path)
+{
+    std::vector<std::string> sync_dbs;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(db_path + "sync", error)) {
+        if (entry.path().extension() == ".db") sync_dbs.push_back(entry.path());
+    }
+    std::sort(sync_dbs.begin(), sync_dbs.end());
+    return sync_dbs;
+}
+
+
+std::string Local_DB::Signature() const
+{
+    // ? local/ changes its mtime whenever pacman adds or removes a package directory
+    std::string signature = File_Stamp(db_path + "local");
+    for (const auto &sync_db : Sync_DBs(db_path)) signature += ' ' + sync_db + '=' + File_Stamp(sync_db);
+    return signature;
+}
+
+
+bool Local_DB::Read_Cache(const std::string &signature, std::vector<Installed_PKG> &pkgs) const
+{
+    std::ifstream cache(cache_file);
+    std::string magic;
+    std::string cached_signature;
+    if (!std::getline(cache, magic) || magic != CACHE_MAGIC) return false;
+    if (!std::getline(cache, cached_signature) || cached_signature != signature) return false;
+
+    std::string line;
+    while (std::getline(cache, line)) {
+        std::istringstream iss(line);
+        Installed_PKG pkg;
+        if (!(iss >> pkg.name >> pkg.version >> pkg.foreign)) return false;
+
+        std::string provide;
+        while (iss >> provide) pkg.provides.push_back(provide);
+        pkgs.push_back(std::move(pkg));
+    }
+    return true;
+}
+
+
+void Local_DB::Write_Cache(const std::string &signature, const std::vector<Installed_PKG> &pkgs) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(cache_file).parent_path(), error);
+
+    const std::string tmp_file = cache_file + ".tmp";
+    std::ofstream cache(tmp_file, std::ios::trunc);
+    cache << CACHE_MAGIC << '\n' << signature << '\n';
+    for (const auto &pkg : pkgs) {
+        cache << pkg.name << ' ' << pkg.version << ' ' << pkg.foreign;
+        for (const auto &provide : pkg.provides) cache << ' ' << provide;
+        cache << '\n';
+    }
+    cache.close();
+
+    if (cache) std::filesystem::rename(tmp_file, cache_file, error);
+}
+
+
+std::string_view Desc_Field(std::string_view desc, std::string_view field)
+{
+    std::size_t position = 0;
+    while ((position = desc.find(field, position)) != std::string_view::npos) {
+        const bool line_start = position == 0 || desc[position - 1] == '\n';
+        position += field.size();
+        if (!line_start || position >= desc.size() || desc[position] != '\n') continue;
+
+        std::string_view value = desc.substr(position + 1);
+        return value.substr(0, value.find('\n'));
+    }
+    return {};
+}
+
+
+std::vector<std::string> Desc_List(std::string_view desc, std::string_view field)
+{
+    std::vector<std::string> list;
+    std::string_view value = Desc_Field(desc, field);
+    if (value.empty()) return list;
+
+    // ? The section runs from its first value up to the next empty line
+    std::string_view section = desc.substr(value.data() - desc.data());
+    while (!section.empty() && section.front() != '\n') {
+        std::size_t line_end = section.find('\n');
+        list.emplace_back(section.substr(0, line_end));
+        if (line_end == std::string_view::npos) break;
+        section.remove_prefix(line_end + 1);
+    }
+    return list;
+}
+
+
+static bool Read_File(const std::string &path, std::string &buffer)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    buffer.clear();
+    char chunk[8192];
+    ssize_t read_size;
+    while ((read_size = read(fd, chunk, sizeof(chunk))) > 0) buffer.append(chunk, read_size);
+    close(fd);
+    return read_size == 0;
+}
+
+
+bool Local_DB::Read_Local(std::vector<Installed_PKG> &pkgs) const
+{
+    std::vector<std::string> pkg_dirs;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(db_path + "local", error)) {
+        if (entry.is_directory(error)) pkg_dirs.push_back(entry.path());
+    }
+    if (error) {
+        std::cerr << WARNING_COLOUR << "Failed to read " << db_path << "local: " << error.message() << '\n' << RESET;
+        return false;
+    }
+
+    // ? Workers claim directories off a shared counter and only write to their own slots
+    std::vector<Installed_PKG> results(pkg_dirs.size());
+    std::atomic<std::size_t> next_dir{0};
+    auto Worker = [&]() {
+        std::string desc;
+        for (std::size_t i = next_dir++; i < pkg_dirs.size(); i = next_dir++) {
+            if (!Read_File(pkg_dirs[i] + "/desc", desc)) continue;
+            results[i].name = Desc_Field(desc, "%NAME%");
+            results[i].version = Desc_Field(desc, "%VERSION%");
+            results[i].provides = Desc_List(desc, "%PROVIDES%");
+        }
+    };
+
+    const std::size_t thread_count = std::min<std::size_t>(std::max(1u, std::thread::hardware_concurrency()), pkg_dirs.size() / 64 + 1);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < thread_count; i++) threads.emplace_back(Worker);
+    Worker();
+    for (auto &thread : threads) thread.join();
+
+    for (auto &pkg : results) {
+        if (!pkg.name.empty()) pkgs.push_back(std::move(pkg));
+    }
+    return true;
+}
+
+
+bool Local_DB::Read_Sync_Names(std::unordered_set<std::string> &sync_names) const
+{
+    for (const auto &sync_db : Sync_DBs(db_path)) {
+        archive *db = archive_read_new();
+        archive_read_support_filter_all(db);
+        archive_read_support_format_all(db);
+
+        if (archive_read_open_filename(db, sync_db.c_str(), 65536) != ARCHIVE_OK) {
+            std::cerr << WARNING_COLOUR << "Failed to open " << sync_db << ": " << archive_error_string(db) << '\n' << RESET;
+            archive_read_free(db);
+            return false;
+        }
+
+        // ? Entries live under <pkgname>-<pkgver>-<pkgrel>/, and neither pkgver nor pkgrel may contain a hyphen
+        archive_entry *entry;
+        while (archive_read_next_header(db, &entry) == ARCHIVE_OK) {
+            std::string_view path = archive_entry_pathname(entry);
+            if (path.substr(0, 2) == "./") path.remove_prefix(2);
+            std::size_t slash = path.find('/');
+            if (slash == std::string_view::npos) continue;
+
+            std::string_view pkg_dir = path.substr(0, slash);
+            std::size_t pkgrel = pkg_dir.rfind('-');
+            std::size_t pkgver = pkgrel == std::string_view::npos || pkgrel == 0 ? std::string_view::npos : pkg_dir.rfind('-', pkgrel - 1);
+            if (pkgver != std::string_view::npos) sync_names.emplace(pkg_dir.substr(0, pkgver));
+        }
+        archive_read_free(db);
+    }
+    return true;
+}
+
+
+bool Local_DB::Read(std::vector<Installed_PKG> &pkgs)
+{
+    const std::string signature = Signature();
+    if (Read_Cache(signature, pkgs)) return true;
+    pkgs.clear();
+
+    std::unordered_set<std::string> sync_names;
+    if (!Read_Local(pkgs) || !Read_Sync_Names(sync_names)) return false;
+
+    for (auto &pkg : pkgs) pkg.foreign = sync_names.count(pkg.name) == 0;
+    Write_Cache(signature, pkgs);
+    return true;
+}
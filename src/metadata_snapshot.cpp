@@ -0,0 +1,149 @@
+#include "../include/colours.hpp"
+#include "../include/rpc_client.hpp"
+#include "../include/metadata_snapshot.hpp"
+#include "../include/json_stream.hpp"
+#include "../include/gzip_stream.hpp"
+#include <nlohmann/json.hpp>
+#include <sys/stat.h>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+
+using json = nlohmann::json;
+
+static const std::string INDEX_FILE = "packages.idx";
+static const std::string DUMP_FILE = "packages-meta-ext-v1.json";
+
+
+Metadata_Snapshot::Metadata_Snapshot(const std::string &cache_dir)
+    : cache_dir(cache_dir), index_path(cache_dir + INDEX_FILE)
+{
+}
+
+
+std::time_t Metadata_Snapshot::Last_Refresh() const
+{
+    struct stat index_stat;
+    if (stat(index_path.c_str(), &index_stat)) return 0;
+    return index_stat.st_mtime;
+}
+
+
+bool Metadata_Snapshot::Download_Dump(const std::string &dump_path)
+{
+    RPC_Client &client = AUR_Client();
+    std::ofstream dump_file(dump_path, std::ios::binary | std::ios::trunc);
+    if (!dump_file) return false;
+
+    // ? The dump is inflated while it downloads, unless the server already decoded it for us
+    Gzip_Stream gzip([&dump_file](const char *data, std::size_t size) {
+        dump_file.write(data, static_cast<std::streamsize>(size));
+        return dump_file.good();
+    });
+    bool success = false;
+
+    client.Queue(client.Base_URL() + "/" + DUMP_FILE + ".gz",
+        [&gzip](const char *data, std::size_t size) { return gzip.Feed(data, size); },
+        [&success](bool done, long) { success = done; });
+
+    client.Perform();
+    return success && gzip.Finish();
+}
+
+
+bool Metadata_Snapshot::Build_Index(const std::string &dump_path)
+{
+    std::ifstream dump_file(dump_path, std::ios::binary);
+    std::vector<PKG_Info> pkgs;
+    PKG_Info_SAX handler(2, [&pkgs](PKG_Info &&info) { pkgs.push_back(std::move(info)); });
+    if (!dump_file || !json::sax_parse(dump_file, &handler)) {
+        if (!handler.Error().empty()) std::cerr << WARNING_COLOUR << "Failed to parse the metadata dump: " << handler.Error() << '\n' << RESET;
+        return false;
+    }
+
+    // ? Written next to the old index and renamed over it, so readers never see half an index
+    const std::string tmp_path = index_path + ".tmp";
+    if (!Write_Package_Index(tmp_path, pkgs)) return false;
+
+    std::error_code error;
+    std::filesystem::rename(tmp_path, index_path, error);
+    if (error) return false;
+
+    load_failed = !index.Open(index_path);
+    return !load_failed;
+}
+
+
+bool Metadata_Snapshot::Refresh()
+{
+    std::error_code error;
+    std::filesystem::create_directories(cache_dir, error);
+    if (error) {
+        std::cerr << WARNING_COLOUR << "Failed to create " << cache_dir << ": " << error.message() << '\n' << RESET;
+        return false;
+    }
+
+    const std::string dump_path = cache_dir + DUMP_FILE;
+    std::cout << "Downloading AUR metadata...\n";
+    if (!Download_Dump(dump_path)) {
+        std::cerr << WARNING_COLOUR << "Failed to download the AUR metadata dump.\n" << RESET;
+        std::filesystem::remove(dump_path, error);
+        return false;
+    }
+
+    std::cout << "Building package index...\n";
+    const bool success = Build_Index(dump_path);
+    std::filesystem::remove(dump_path, error);
+    if (!success) {
+        std::cerr << WARNING_COLOUR << "Failed to build the package index.\n" << RESET;
+        return false;
+    }
+
+    std::cout << "Indexed " << index.Size() << " packages.\n";
+    return true;
+}
+
+
+bool Metadata_Snapshot::Load()
+{
+    // ? A missing or outdated index is only looked at once per run
+    if (index.Is_Open()) return true;
+    if (load_failed) return false;
+
+    load_failed = !index.Open(index_path);
+    return !load_failed;
+}
+
+
+std::vector<PKG_Info> Metadata_Snapshot::Search(const std::string &query) const
+{
+    std::vector<PKG_Info> results;
+    std::string lower_query = query;
+    std::transform(lower_query.begin(), lower_query.end(), lower_query.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    // ? Only the NAMES section gets scanned, records and strings are read for matches alone
+    const std::string_view names = index.Names();
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < index.Size() && start < names.size(); i++) {
+        std::size_t end = names.find('\0', start);
+        if (end == std::string_view::npos) break;
+        std::string_view pkg_name = names.substr(start, end - start);
+        start = end + 1;
+
+        auto match = std::search(pkg_name.begin(), pkg_name.end(), lower_query.begin(), lower_query.end(),
+            [](char a, char b) { return std::tolower(static_cast<unsigned char>(a)) == b; });
+        if (match != pkg_name.end()) results.push_back(index.Info(i));
+    }
+    return results;
+}
+
+
+bool Metadata_Snapshot::Find(const std::string &pkg_name, PKG_Info &info) const
+{
+    std::size_t record = index.Find(pkg_name);
+    if (record == index.Size()) return false;
+
+    info = index.Info(record);
+    return true;
+}
@@ -0,0 +1,236 @@
+#include "../include/colours.hpp"
+#include "../include/package_index.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace Index_Format;
+
+
+static void Align(std::string &buffer, std::size_t alignment)
+{
+    buffer.resize((buffer.size() + alignment - 1) / alignment * alignment, '\0');
+}
+
+
+bool Write_Package_Index(const std::string &path, const std::vector<PKG_Info> &pkgs)
+{
+    std::vector<const PKG_Info*> sorted;
+    sorted.reserve(pkgs.size());
+    for (const auto &pkg : pkgs) sorted.push_back(&pkg);
+    std::sort(sorted.begin(), sorted.end(), [](const PKG_Info *a, const PKG_Info *b) { return a->name < b->name; });
+
+    std::string strings;
+    auto Add_String = [&strings](const std::string &text) {
+        String_Ref ref{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(text.size()) };
+        strings += text;
+        return ref;
+    };
+
+    std::vector<String_Ref> lists;
+    auto Add_List = [&lists, &Add_String](const std::vector<std::string> &list) {
+        List_Ref ref{ static_cast<uint32_t>(lists.size()), static_cast<uint32_t>(list.size()) };
+        for (const auto &text : list) lists.push_back(Add_String(text));
+        return ref;
+    };
+
+    std::vector<Index_Record> records;
+    std::string names;
+    std::vector<uint32_t> name_offsets;
+    records.reserve(sorted.size());
+    name_offsets.reserve(sorted.size());
+    for (const auto *pkg : sorted) {
+        name_offsets.push_back(static_cast<uint32_t>(names.size()));
+        names += pkg->name;
+        names += '\0';
+        records.push_back({ Add_String(pkg->package_base), Add_String(pkg->version), Add_String(pkg->description),
+                            Add_List(pkg->depends), Add_List(pkg->make_depends), Add_List(pkg->check_depends) });
+    }
+
+    // ? Lay the file out in memory first, sections are 8 byte aligned so records can be read in place
+    const std::size_t section_count = 5;
+    std::string file(sizeof(Index_Header) + section_count * sizeof(Section_Header), '\0');
+    std::vector<Section_Header> sections;
+    auto Add_Section = [&](Section_ID id, const void *section_data, std::size_t size) {
+        Align(file, 8);
+        sections.push_back({ id, 0, file.size(), size });
+        file.append(static_cast<const char*>(section_data), size);
+    };
+
+    Add_Section(RECORDS, records.data(), records.size() * sizeof(Index_Record));
+    Add_Section(NAMES, names.data(), names.size());
+    Add_Section(OFFSETS, name_offsets.data(), name_offsets.size() * sizeof(uint32_t));
+    Add_Section(LISTS, lists.data(), lists.size() * sizeof(String_Ref));
+    Add_Section(STRINGS, strings.data(), strings.size());
+
+    Index_Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.section_count = static_cast<uint32_t>(sections.size());
+    std::memcpy(file.data(), &header, sizeof(header));
+    std::memcpy(file.data() + sizeof(header), sections.data(), sections.size() * sizeof(Section_Header));
+
+    std::ofstream index_file(path, std::ios::binary | std::ios::trunc);
+    index_file.write(file.data(), static_cast<std::streamsize>(file.size()));
+    index_file.close();
+    return index_file.good();
+}
+
+
+Package_Index::~Package_Index()
+{
+    Close();
+}
+
+
+void Package_Index::Close()
+{
+    if (data) munmap(const_cast<char*>(data), data_size);
+    data = nullptr;
+    data_size = 0;
+    records = nullptr;
+    names = nullptr;
+    name_offsets = nullptr;
+    lists = nullptr;
+    strings = nullptr;
+    record_count = 0;
+    names_size = 0;
+    list_size = 0;
+    strings_size = 0;
+}
+
+
+bool Package_Index::Open(const std::string &path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) || static_cast<std::size_t>(file_stat.st_size) < sizeof(Index_Header)) {
+        close(fd);
+        return false;
+    }
+
+    void *mapping = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    data = static_cast<const char*>(mapping);
+    data_size = file_stat.st_size;
+
+    // ? Validate everything up front, so the accessors never have to
+    const auto *header = reinterpret_cast<const Index_Header*>(data);
+    if (std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) || header->version != VERSION) {
+        std::cerr << WARNING_COLOUR << "Package index " << path << " has an unknown format, run hone --refresh.\n" << RESET;
+        Close();
+        return false;
+    }
+
+    if (sizeof(Index_Header) + header->section_count * sizeof(Section_Header) > data_size) {
+        Close();
+        return false;
+    }
+
+    const auto *sections = reinterpret_cast<const Section_Header*>(data + sizeof(Index_Header));
+    std::size_t offset_count = 0;
+    for (uint32_t i = 0; i < header->section_count; i++) {
+        const Section_Header &section = sections[i];
+        if (section.offset % 8 || section.offset > data_size || section.size > data_size - section.offset) {
+            Close();
+            return false;
+        }
+
+        switch (section.id) {
+        case RECORDS:
+            records = reinterpret_cast<const Index_Record*>(data + section.offset);
+            record_count = section.size / sizeof(Index_Record);
+            break;
+        case NAMES:
+            names = data + section.offset;
+            names_size = section.size;
+            break;
+        case OFFSETS:
+            name_offsets = reinterpret_cast<const uint32_t*>(data + section.offset);
+            offset_count = section.size / sizeof(uint32_t);
+            break;
+        case LISTS:
+            lists = reinterpret_cast<const String_Ref*>(data + section.offset);
+            list_size = section.size / sizeof(String_Ref);
+            break;
+        case STRINGS:
+            strings = data + section.offset;
+            strings_size = section.size;
+            break;
+        }
+    }
+
+    // ? Name() relies on NAMES ending in '\0', whatever the offsets say
+    if (!records || !names || !name_offsets || !lists || !strings || offset_count != record_count
+        || (record_count && (names_size == 0 || names[names_size - 1] != '\0'))) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+
+std::string_view Package_Index::String(const String_Ref &ref) const
+{
+    if (ref.offset > strings_size || ref.length > strings_size - ref.offset) return {};
+    return { strings + ref.offset, ref.length };
+}
+
+
+std::vector<std::string> Package_Index::List(const List_Ref &ref) const
+{
+    std::vector<std::string> list;
+    if (ref.offset > list_size || ref.count > list_size - ref.offset) return list;
+
+    list.reserve(ref.count);
+    for (uint32_t i = 0; i < ref.count; i++) list.emplace_back(String(lists[ref.offset + i]));
+    return list;
+}
+
+
+std::string_view Package_Index::Name(std::size_t index) const
+{
+    const uint32_t offset = name_offsets[index];
+    if (offset >= names_size) return {};
+    return { names + offset, strnlen(names + offset, names_size - offset) };
+}
+
+
+PKG_Info Package_Index::Info(std::size_t index) const
+{
+    const Index_Record &record = records[index];
+    PKG_Info info;
+    info.name = Name(index);
+    info.package_base = String(record.package_base);
+    info.version = String(record.version);
+    info.description = String(record.description);
+    info.depends = List(record.depends);
+    info.make_depends = List(record.make_depends);
+    info.check_depends = List(record.check_depends);
+    return info;
+}
+
+
+std::size_t Package_Index::Find(std::string_view pkg_name) const
+{
+    std::size_t low = 0;
+    std::size_t high = record_count;
+    while (low < high) {
+        std::size_t middle = low + (high - low) / 2;
+        if (Name(middle) < pkg_name) low = middle + 1;
+        else high = middle;
+    }
+    return low < record_count && Name(low) == pkg_name ? low : record_count;
+}
+
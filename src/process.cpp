@@ -0,0 +1,305 @@
+#include "../include/colours.hpp"
+#include "../include/process.hpp"
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unordered_map>
+#include <filesystem>
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <spawn.h>
+
+extern char **environ;
+
+// ? epoll user data carries the child's index, and whether the event is for its output pipe
+static const std::uint64_t OUTPUT_FLAG = 1;
+// ? Compilers of a parallel make live for seconds, so this catches them running side by side
+static const int MEMORY_SAMPLE_MS = 250;
+
+
+static int Pidfd_Open(pid_t pid)
+{
+#ifdef SYS_pidfd_open
+    return static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+
+// ? Summed resident set of every process in /proc, grouped by the root of their tree among roots
+static std::unordered_map<pid_t, long> Tree_RSS_KB(const std::vector<pid_t> &roots)
+{
+    std::unordered_map<pid_t, pid_t> parents;
+    std::unordered_map<pid_t, long> rss_kb;
+    const long page_kb = sysconf(_SC_PAGESIZE) / 1024;
+
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator("/proc", error)) {
+        const std::string name = entry.path().filename().string();
+        if (name.find_first_not_of("0123456789") != std::string::npos) continue;
+        const pid_t pid = static_cast<pid_t>(std::stol(name));
+
+        // ? The command name may hold spaces and parentheses, the fields after it do not
+        std::ifstream stat_file(entry.path() / "stat");
+        std::string stat;
+        std::getline(stat_file, stat);
+        std::size_t name_end = stat.rfind(')');
+        if (name_end == std::string::npos) continue;
+        char state;
+        int parent;
+        if (std::sscanf(stat.c_str() + name_end + 1, " %c %d", &state, &parent) != 2) continue;
+
+        std::ifstream statm_file(entry.path() / "statm");
+        long size_pages;
+        long resident_pages;
+        if (!(statm_file >> size_pages >> resident_pages)) continue;
+        parents[pid] = parent;
+        rss_kb[pid] = resident_pages * page_kb;
+    }
+
+    std::unordered_map<pid_t, long> totals;
+    for (pid_t root : roots) totals[root] = 0;
+    for (const auto &[pid, resident_kb] : rss_kb) {
+        // ? Walks up to a root or to init, process trees are shallow
+        pid_t ancestor = pid;
+        for (int depth = 0; depth < 64 && ancestor > 1 && !totals.count(ancestor); depth++) {
+            auto parent = parents.find(ancestor);
+            ancestor = parent == parents.end() ? 0 : parent->second;
+        }
+        auto total = totals.find(ancestor);
+        if (total != totals.end()) total->second += resident_kb;
+    }
+    return totals;
+}
+
+
+static std::vector<std::string> Child_Environment(const std::vector<std::string> &overrides)
+{
+    std::vector<std::string> environment;
+    for (char **variable = environ; *variable; variable++) {
+        std::string entry(*variable);
+        std::string name = entry.substr(0, entry.find('='));
+        bool overridden = false;
+        for (const auto &override_entry : overrides) {
+            if (override_entry.compare(0, name.size() + 1, name + "=") == 0) overridden = true;
+        }
+        if (!overridden) environment.push_back(std::move(entry));
+    }
+    environment.insert(environment.end(), overrides.begin(), overrides.end());
+    return environment;
+}
+
+
+Process_Group::Process_Group()
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+}
+
+
+Process_Group::~Process_Group()
+{
+    Wait();
+    if (epoll_fd >= 0) close(epoll_fd);
+}
+
+
+bool Process_Group::Spawn(const Process_Options &options, Exit_Callback on_exit, Output_Callback on_output)
+{
+    if (options.args.empty() || epoll_fd < 0) return false;
+
+    std::vector<char*> argv;
+    for (const auto &arg : options.args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+
+    std::vector<std::string> environment = Child_Environment(options.environment);
+    std::vector<char*> envp;
+    for (const auto &entry : environment) envp.push_back(const_cast<char*>(entry.c_str()));
+    envp.push_back(nullptr);
+
+    // ? The pipe is close-on-exec, so children spawned by other threads never inherit it
+    int output_pipe[2] = { -1, -1 };
+    if (options.capture_output && pipe2(output_pipe, O_CLOEXEC)) return false;
+
+    // ? File actions run in order, the log is opened before changing directory so relative paths mean the same as for hone
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (!options.log_file.empty()) {
+        posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, options.log_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+    }
+    if (options.capture_output) posix_spawn_file_actions_adddup2(&actions, output_pipe[1], STDOUT_FILENO);
+    // ? dup2 onto itself clears FD_CLOEXEC in the child only, hone and its other children keep the flag
+    for (int fd : options.inherit_fds) posix_spawn_file_actions_adddup2(&actions, fd, fd);
+    if (!options.working_dir.empty()) posix_spawn_file_actions_addchdir_np(&actions, options.working_dir.c_str());
+
+    pid_t pid;
+    int error = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), envp.data());
+    posix_spawn_file_actions_destroy(&actions);
+    if (output_pipe[1] >= 0) close(output_pipe[1]);
+    if (error) {
+        if (output_pipe[0] >= 0) close(output_pipe[0]);
+        std::cerr << WARNING_COLOUR << "Failed to run " << options.args[0] << ": " << strerror(error) << '\n' << RESET;
+        return false;
+    }
+
+    auto child = std::make_unique<Child>();
+    child->pid = pid;
+    child->start_time = std::chrono::steady_clock::now();
+    child->sample_memory = options.sample_memory;
+    child->on_exit = std::move(on_exit);
+    child->on_output = std::move(on_output);
+    const std::uint64_t index = children.size();
+
+    child->pidfd = Pidfd_Open(pid);
+    if (child->pidfd >= 0) {
+        fcntl(child->pidfd, F_SETFD, FD_CLOEXEC);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = index << 1;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, child->pidfd, &event);
+    } else needs_polling = true;
+
+    if (output_pipe[0] >= 0) {
+        child->output_fd = output_pipe[0];
+        fcntl(child->output_fd, F_SETFL, fcntl(child->output_fd, F_GETFL) | O_NONBLOCK);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = (index << 1) | OUTPUT_FLAG;
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, child->output_fd, &event);
+    }
+
+    children.push_back(std::move(child));
+    running++;
+    return true;
+}
+
+
+void Process_Group::Read_Output(Child &child)
+{
+    char buffer[65536];
+    while (child.output_fd >= 0) {
+        ssize_t read_size = read(child.output_fd, buffer, sizeof(buffer));
+        if (read_size > 0) {
+            if (child.on_output) child.on_output(buffer, static_cast<std::size_t>(read_size));
+            continue;
+        }
+        if (read_size < 0 && errno == EINTR) continue;
+        if (read_size < 0 && errno == EAGAIN) return;
+
+        // ? End of output, or an error that ends it just the same
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, child.output_fd, nullptr);
+        close(child.output_fd);
+        child.output_fd = -1;
+    }
+}
+
+
+void Process_Group::Reap(Child &child, bool block)
+{
+    if (child.exited) return;
+
+    int status;
+    struct rusage resources{};
+    pid_t result;
+    do result = wait4(child.pid, &status, block ? 0 : WNOHANG, &resources);
+    while (result < 0 && errno == EINTR);
+    if (result == 0) return;
+
+    child.exited = true;
+    if (result < 0) child.exit_code = -1;
+    else child.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+    child.usage.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - child.start_time).count();
+    child.usage.cpu_seconds = resources.ru_utime.tv_sec + resources.ru_stime.tv_sec + (resources.ru_utime.tv_usec + resources.ru_stime.tv_usec) / 1e6;
+    // ? A short spike of one process can fall between samples, ru_maxrss still has it
+    child.usage.peak_rss_kb = std::max(child.usage.peak_rss_kb, static_cast<long>(resources.ru_maxrss));
+
+    if (child.pidfd >= 0) {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, child.pidfd, nullptr);
+        close(child.pidfd);
+        child.pidfd = -1;
+    }
+}
+
+
+void Process_Group::Sample_Memory()
+{
+    std::vector<pid_t> roots;
+    for (const auto &child : children) {
+        if (child->pid >= 0 && !child->exited && child->sample_memory) roots.push_back(child->pid);
+    }
+    if (roots.empty()) return;
+
+    const std::unordered_map<pid_t, long> totals = Tree_RSS_KB(roots);
+    for (auto &child : children) {
+        auto total = totals.find(child->pid);
+        if (child->pid < 0 || child->exited || total == totals.end()) continue;
+        child->usage.peak_rss_kb = std::max(child->usage.peak_rss_kb, total->second);
+    }
+}
+
+
+void Process_Group::Finish_If_Done(Child &child)
+{
+    if (child.pid < 0 || !child.exited || child.output_fd >= 0) return;
+
+    Exit_Callback on_exit = std::move(child.on_exit);
+    child.pid = -1;
+    running--;
+    if (on_exit) on_exit(child.exit_code, child.usage);
+}
+
+
+void Process_Group::Wait()
+{
+    auto next_sample = std::chrono::steady_clock::now();
+    while (running > 0) {
+        const bool sampling = std::any_of(children.begin(), children.end(), [](const std::unique_ptr<Child> &child) {
+            return child->pid >= 0 && !child->exited && child->sample_memory;
+        });
+        if (sampling && std::chrono::steady_clock::now() >= next_sample) {
+            Sample_Memory();
+            next_sample = std::chrono::steady_clock::now() + std::chrono::milliseconds(MEMORY_SAMPLE_MS);
+        }
+
+        epoll_event events[16];
+        int count = epoll_wait(epoll_fd, events, 16, needs_polling ? 50 : sampling ? MEMORY_SAMPLE_MS : -1);
+        if (count < 0 && errno != EINTR) {
+            // ? Without epoll the children can still be waited for one by one, with blocking reads
+            for (auto &child : children) {
+                if (child->pid < 0) continue;
+                if (child->output_fd >= 0) fcntl(child->output_fd, F_SETFL, fcntl(child->output_fd, F_GETFL) & ~O_NONBLOCK);
+                Read_Output(*child);
+                Reap(*child, true);
+                Finish_If_Done(*child);
+            }
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            Child &child = *children[events[i].data.u64 >> 1];
+            if (events[i].data.u64 & OUTPUT_FLAG) Read_Output(child);
+            else Reap(child, true);
+            Finish_If_Done(child);
+        }
+
+        if (needs_polling) {
+            for (auto &child : children) {
+                if (child->pid < 0 || child->pidfd >= 0) continue;
+                Reap(*child, false);
+                Finish_If_Done(*child);
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "../include/colours.hpp"
+#include "../include/resolver.hpp"
+#include <unordered_set>
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+
+Dependency_Resolver::Dependency_Resolver(const Installed_Store &installed, const Sync_DB &sync_db, Info_Source fetch_infos)
+    : installed(installed), sync_db(sync_db), fetch_infos(std::move(fetch_infos))
+{
+}
+
+
+bool Dependency_Resolver::Resolve(const std::vector<std::string> &targets, Build_Plan &plan)
+{
+    std::unordered_map<std::string, Build_Node> nodes;
+    std::unordered_map<std::string, std::string> base_of_pkg;
+    // ? Package base, to the names of the AUR packages it depends on
+    std::unordered_map<std::string, std::vector<std::string>> wanted_names;
+    std::unordered_set<std::string> seen;
+    std::unordered_set<std::string> target_set(targets.begin(), targets.end());
+    std::unordered_set<std::string> repo_depends;
+    std::unordered_set<std::string> repo_make_depends;
+    PKG_Info_Map pkg_infos;
+
+    // ? A target named twice is still only looked at once
+    std::vector<std::string> level;
+    for (const auto &target : targets) {
+        if (seen.insert(target).second) level.push_back(target);
+    }
+    while (!level.empty()) {
+        if (!fetch_infos(level, pkg_infos)) return false;
+
+        std::vector<std::string> next_level;
+        for (const auto &pkg_name : level) {
+            auto info = pkg_infos.find(pkg_name);
+            if (info == pkg_infos.end()) {
+                plan.missing.push_back(pkg_name);
+                continue;
+            }
+
+            const PKG_Info &pkg = info->second;
+            Build_Node &node = nodes[pkg.package_base];
+            node.package_base = pkg.package_base;
+            node.version = pkg.version;
+            node.pkg_names.push_back(pkg.name);
+            if (target_set.count(pkg.name)) node.is_dependency = false;
+            base_of_pkg[pkg.name] = pkg.package_base;
+
+            for (const auto *list : { &pkg.depends, &pkg.make_depends, &pkg.check_depends }) {
+                for (const auto &depend : *list) {
+                    Dependency dep = Parse_Dependency(depend);
+                    if (installed.Satisfies(dep)) continue;
+                    if (sync_db.Satisfies(dep)) {
+                        if (list == &pkg.depends) repo_depends.insert(dep.name);
+                        else repo_make_depends.insert(dep.name);
+                        continue;
+                    }
+
+                    wanted_names[pkg.package_base].push_back(dep.name);
+                    if (seen.insert(dep.name).second) next_level.push_back(dep.name);
+                }
+            }
+        }
+        level = std::move(next_level);
+    }
+
+    for (auto &[package_base, pkg_names] : wanted_names) {
+        Build_Node &node = nodes[package_base];
+        for (const auto &pkg_name : pkg_names) {
+            auto dependency_base = base_of_pkg.find(pkg_name);
+            // ? Split packages may depend on their siblings, those come out of the same build
+            if (dependency_base == base_of_pkg.end() || dependency_base->second == package_base) continue;
+            if (std::find(node.dependencies.begin(), node.dependencies.end(), dependency_base->second) == node.dependencies.end()) {
+                node.dependencies.push_back(dependency_base->second);
+            }
+        }
+    }
+
+    plan.repo_depends.assign(repo_depends.begin(), repo_depends.end());
+    std::sort(plan.repo_depends.begin(), plan.repo_depends.end());
+    for (const auto &pkg_name : repo_make_depends) {
+        if (!repo_depends.count(pkg_name)) plan.repo_make_depends.push_back(pkg_name);
+    }
+    std::sort(plan.repo_make_depends.begin(), plan.repo_make_depends.end());
+
+    if (!plan.missing.empty()) {
+        std::cerr << WARNING_COLOUR << "Could not find these packages in the AUR or any repository:" << RESET;
+        for (const auto &pkg_name : plan.missing) std::cerr << ' ' << pkg_name;
+        std::cerr << '\n';
+        return false;
+    }
+
+    return Sort_Nodes(nodes, plan);
+}
+
+
+// ? Kahn's algorithm, with ties broken by name so the same input always gives the same order
+bool Dependency_Resolver::Sort_Nodes(std::unordered_map<std::string, Build_Node> &nodes, Build_Plan &plan)
+{
+    std::map<std::string, std::size_t> pending_count;
+    std::unordered_map<std::string, std::vector<std::string>> dependents;
+    for (const auto &[package_base, node] : nodes) {
+        pending_count[package_base] = node.dependencies.size();
+        for (const auto &dependency : node.dependencies) dependents[dependency].push_back(package_base);
+    }
+
+    std::vector<std::string> ready;
+    for (const auto &[package_base, count] : pending_count) {
+        if (count == 0) ready.push_back(package_base);
+    }
+
+    while (!ready.empty()) {
+        std::sort(ready.begin(), ready.end(), std::greater<>());
+        std::string package_base = ready.back();
+        ready.pop_back();
+
+        pending_count.erase(package_base);
+        for (const auto &dependent : dependents[package_base]) {
+            if (--pending_count[dependent] == 0) ready.push_back(dependent);
+        }
+        plan.nodes.push_back(std::move(nodes[package_base]));
+    }
+
+    if (!pending_count.empty()) {
+        std::cerr << WARNING_COLOUR << "Dependency cycle between these packages:" << RESET;
+        for (const auto &[package_base, count] : pending_count) std::cerr << ' ' << package_base;
+        std::cerr << '\n';
+        return false;
+    }
+    return true;
+}
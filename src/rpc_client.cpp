@@ -0,0 +1,144 @@
+#include "../include/rpc_client.hpp"
+#include <cstdlib>
+
+static const std::string AUR_URL = "https://aur.archlinux.org";
+static const long CONNECT_TIMEOUT = 30;
+
+
+RPC_Client::RPC_Client(const std::string &base_url, std::size_t max_in_flight)
+    : base_url(base_url), max_in_flight(max_in_flight ? max_in_flight : 1)
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    multi = curl_multi_init();
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(this->max_in_flight));
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, static_cast<long>(this->max_in_flight));
+}
+
+
+RPC_Client::~RPC_Client()
+{
+    for (auto *easy : idle_handles) curl_easy_cleanup(easy);
+    curl_multi_cleanup(multi);
+    curl_global_cleanup();
+}
+
+
+void RPC_Client::Queue(const std::string &url, Data_Callback on_data, Done_Callback on_done)
+{
+    pending.push_back({ url, std::move(on_data), std::move(on_done) });
+}
+
+
+std::size_t RPC_Client::Write_Callback(void *contents, std::size_t size, std::size_t nmemb, void *userp)
+{
+    auto *request = static_cast<Request*>(userp);
+    if (request->on_data && !request->on_data(static_cast<char*>(contents), size * nmemb)) return 0;
+    return size * nmemb;
+}
+
+
+void RPC_Client::Start_Pending()
+{
+    while (in_flight < max_in_flight && !pending.empty()) {
+        CURL *easy;
+        if (idle_handles.empty()) {
+            easy = curl_easy_init();
+            if (!easy) return;
+        } else {
+            easy = idle_handles.back();
+            idle_handles.pop_back();
+        }
+
+        auto *request = new Request(std::move(pending.front()));
+        pending.pop_front();
+
+        curl_easy_setopt(easy, CURLOPT_URL, request->url.c_str());
+        curl_easy_setopt(easy, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, Write_Callback);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, request);
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, request);
+        curl_easy_setopt(easy, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+        curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT);
+        curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+        // ? Wait for an existing connection to multiplex on, instead of opening another one
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+
+        curl_multi_add_handle(multi, easy);
+        in_flight++;
+    }
+}
+
+
+bool RPC_Client::Finish(CURL *easy, CURLcode result)
+{
+    Request *request = nullptr;
+    long status = 0;
+    curl_easy_getinfo(easy, CURLINFO_PRIVATE, &request);
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+
+    curl_multi_remove_handle(multi, easy);
+    curl_easy_reset(easy);
+    idle_handles.push_back(easy);
+    in_flight--;
+
+    const bool success = result == CURLE_OK && status < 400;
+    if (request->on_done) request->on_done(success, status);
+    delete request;
+    return success;
+}
+
+
+bool RPC_Client::Perform()
+{
+    bool success = true;
+    int running = 0;
+
+    Start_Pending();
+    while (in_flight > 0) {
+        if (curl_multi_perform(multi, &running) != CURLM_OK) return false;
+
+        int messages_left = 0;
+        while (CURLMsg *message = curl_multi_info_read(multi, &messages_left)) {
+            if (message->msg != CURLMSG_DONE) continue;
+            if (!Finish(message->easy_handle, message->data.result)) success = false;
+        }
+
+        // ? Callbacks may have queued follow-up requests
+        Start_Pending();
+        if (running > 0) curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+
+    return success;
+}
+
+
+bool RPC_Client::Get(const std::string &url, std::string &body)
+{
+    bool success = false;
+    Queue(url,
+        [&body](const char *data, std::size_t size) { body.append(data, size); return true; },
+        [&success](bool done, long) { success = done; });
+    Perform();
+    return success;
+}
+
+
+std::string RPC_Client::Escape(const std::string &text)
+{
+    char *escaped = curl_easy_escape(nullptr, text.c_str(), static_cast<int>(text.size()));
+    if (!escaped) return "";
+    std::string result = escaped;
+    curl_free(escaped);
+    return result;
+}
+
+
+RPC_Client &AUR_Client()
+{
+    static const char *url_override = std::getenv("HONE_AUR_URL");
+    static RPC_Client client(url_override ? url_override : AUR_URL);
+    return client;
+}
@@ -0,0 +1,54 @@
+#include "../include/session.hpp"
+
+
+Session::Session(Info_Source fetch_infos)
+    : fetch_infos(std::move(fetch_infos))
+{
+}
+
+
+bool Session::PKG_Infos(const std::vector<std::string> &pkg_names, PKG_Info_Map &pkg_infos)
+{
+    std::vector<std::string> to_fetch;
+    std::unordered_set<std::string> queued;
+    for (const auto &pkg_name : pkg_names) {
+        auto known = known_infos.find(pkg_name);
+        if (known != known_infos.end()) pkg_infos[pkg_name] = known->second;
+        else if (!unknown_names.count(pkg_name) && queued.insert(pkg_name).second) to_fetch.push_back(pkg_name);
+    }
+    if (to_fetch.empty()) return true;
+
+    PKG_Info_Map fetched;
+    const bool success = fetch_infos(to_fetch, fetched);
+    for (const auto &pkg_name : to_fetch) {
+        auto info = fetched.find(pkg_name);
+        if (info != fetched.end()) {
+            pkg_infos[pkg_name] = info->second;
+            known_infos[pkg_name] = std::move(info->second);
+        }
+        // ? After a failed request a missing record may just not have arrived, so it is asked for again next time
+        else if (success) unknown_names.insert(pkg_name);
+    }
+    return success;
+}
+
+
+const Build_Plan *Session::Plan_For(const std::vector<std::string> &targets) const
+{
+    return plan && plan_targets == targets ? &*plan : nullptr;
+}
+
+
+void Session::Remember_Plan(const std::vector<std::string> &targets, const Build_Plan &new_plan)
+{
+    plan_targets = targets;
+    plan = new_plan;
+}
+
+
+void Session::Installed_Changed()
+{
+    updates.reset();
+    plan.reset();
+    plan_targets.clear();
+}
@@ -0,0 +1,119 @@
+#include "../include/sha256.hpp"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+static const std::uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+
+static inline std::uint32_t Rotate(std::uint32_t value, int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+
+SHA256::SHA256()
+    : state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 }
+{
+}
+
+
+void SHA256::Transform(const std::uint8_t *data)
+{
+    std::uint32_t schedule[64];
+    for (int i = 0; i < 16; i++) {
+        schedule[i] = std::uint32_t(data[i * 4]) << 24 | std::uint32_t(data[i * 4 + 1]) << 16 | std::uint32_t(data[i * 4 + 2]) << 8 | data[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        std::uint32_t s0 = Rotate(schedule[i - 15], 7) ^ Rotate(schedule[i - 15], 18) ^ (schedule[i - 15] >> 3);
+        std::uint32_t s1 = Rotate(schedule[i - 2], 17) ^ Rotate(schedule[i - 2], 19) ^ (schedule[i - 2] >> 10);
+        schedule[i] = schedule[i - 16] + s0 + schedule[i - 7] + s1;
+    }
+
+    std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        std::uint32_t s1 = Rotate(e, 6) ^ Rotate(e, 11) ^ Rotate(e, 25);
+        std::uint32_t choose = (e & f) ^ (~e & g);
+        std::uint32_t temp1 = h + s1 + choose + ROUND_CONSTANTS[i] + schedule[i];
+        std::uint32_t s0 = Rotate(a, 2) ^ Rotate(a, 13) ^ Rotate(a, 22);
+        std::uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        std::uint32_t temp2 = s0 + majority;
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+
+void SHA256::Update(const void *data, std::size_t size)
+{
+    const std::uint8_t *bytes = static_cast<const std::uint8_t*>(data);
+    total_size += size;
+
+    if (block_size > 0) {
+        std::size_t take = std::min(size, sizeof(block) - block_size);
+        std::memcpy(block + block_size, bytes, take);
+        block_size += take;
+        bytes += take;
+        size -= take;
+        if (block_size < sizeof(block)) return;
+        Transform(block);
+        block_size = 0;
+    }
+
+    for (; size >= sizeof(block); bytes += sizeof(block), size -= sizeof(block)) Transform(bytes);
+    std::memcpy(block, bytes, size);
+    block_size = size;
+}
+
+
+std::string SHA256::Hex_Digest()
+{
+    const std::uint64_t bit_size = total_size * 8;
+    const std::uint8_t padding = 0x80;
+    const std::uint8_t zero = 0;
+    Update(&padding, 1);
+    while (block_size != 56) Update(&zero, 1);
+
+    std::uint8_t length[8];
+    for (int i = 0; i < 8; i++) length[i] = static_cast<std::uint8_t>(bit_size >> (56 - i * 8));
+    Update(length, sizeof(length));
+
+    static const char HEX[] = "0123456789abcdef";
+    std::string digest;
+    for (std::uint32_t word : state) {
+        for (int shift = 28; shift >= 0; shift -= 4) digest += HEX[(word >> shift) & 0xf];
+    }
+    return digest;
+}
+
+
+std::string SHA256_File(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return "";
+
+    SHA256 hasher;
+    char buffer[65536];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) hasher.Update(buffer, static_cast<std::size_t>(file.gcount()));
+    return hasher.Hex_Digest();
+}
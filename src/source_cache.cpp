@@ -0,0 +1,116 @@
+#include "../include/source_cache.hpp"
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <filesystem>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+
+bool Link_File(const std::string &from, const std::string &to)
+{
+    std::error_code error;
+    std::filesystem::create_hard_link(from, to, error);
+    if (!error) return true;
+    if (std::filesystem::exists(to)) return false;
+
+    const std::string tmp_path = to + ".tmp" + std::to_string(getpid());
+    int from_fd = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+    if (from_fd < 0) return false;
+    int to_fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (to_fd < 0) {
+        close(from_fd);
+        return false;
+    }
+    bool cloned = ioctl(to_fd, FICLONE, from_fd) == 0;
+    close(from_fd);
+    close(to_fd);
+
+    if (!cloned) std::filesystem::copy_file(from, tmp_path, std::filesystem::copy_options::overwrite_existing, error);
+    if (!error) std::filesystem::rename(tmp_path, to, error);
+    if (error) std::filesystem::remove(tmp_path, error);
+    return !error;
+}
+
+
+Source_Cache::Source_Cache(const std::string &cache_dir, std::uintmax_t max_size)
+    : cache_dir(cache_dir), max_size(max_size)
+{
+}
+
+
+std::string Source_Cache::Entry_Path(const Source_Entry &source) const
+{
+    return cache_dir + source.algorithm + "-" + source.checksum;
+}
+
+
+std::size_t Source_Cache::Materialize(const std::string &build_dir) const
+{
+    Srcinfo fields;
+    if (!Read_Srcinfo(build_dir + "/.SRCINFO", fields)) return 0;
+
+    std::size_t count = 0;
+    for (const auto &source : Checksummed_Sources(fields)) {
+        const std::string entry_path = Entry_Path(source);
+        const std::string target = build_dir + "/" + source.file_name;
+        if (std::filesystem::exists(target) || !std::filesystem::exists(entry_path)) continue;
+        if (!Link_File(entry_path, target)) continue;
+
+        // ? The modification time is the entry's last use, Evict() goes by it
+        utimensat(AT_FDCWD, entry_path.c_str(), nullptr, 0);
+        count++;
+    }
+    return count;
+}
+
+
+std::size_t Source_Cache::Store(const std::string &build_dir) const
+{
+    Srcinfo fields;
+    if (!Read_Srcinfo(build_dir + "/.SRCINFO", fields)) return 0;
+
+    std::error_code error;
+    std::filesystem::create_directories(cache_dir, error);
+    if (error) return 0;
+
+    std::size_t count = 0;
+    for (const auto &source : Checksummed_Sources(fields)) {
+        const std::string source_path = build_dir + "/" + source.file_name;
+        const std::string entry_path = Entry_Path(source);
+        // ? Symlinks point into a SRCDEST makepkg manages itself
+        if (!std::filesystem::is_regular_file(std::filesystem::symlink_status(source_path, error)) || std::filesystem::exists(entry_path)) continue;
+        if (Link_File(source_path, entry_path)) count++;
+    }
+    return count;
+}
+
+
+void Source_Cache::Evict() const
+{
+    struct Cache_Entry {
+        std::filesystem::path path;
+        std::uintmax_t size;
+        std::filesystem::file_time_type last_use;
+    };
+
+    std::vector<Cache_Entry> entries;
+    std::uintmax_t total_size = 0;
+    std::error_code error;
+    for (const auto &file : std::filesystem::directory_iterator(cache_dir, error)) {
+        if (!file.is_regular_file(error)) continue;
+        Cache_Entry entry{ file.path(), file.file_size(error), file.last_write_time(error) };
+        if (error) continue;
+        total_size += entry.size;
+        entries.push_back(std::move(entry));
+    }
+    if (total_size <= max_size) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Cache_Entry &a, const Cache_Entry &b) { return a.last_use < b.last_use; });
+    for (const auto &entry : entries) {
+        if (total_size <= max_size) break;
+        if (std::filesystem::remove(entry.path, error)) total_size -= entry.size;
+    }
+}
@@ -0,0 +1,137 @@
+#include "../include/srcinfo.hpp"
+#include <fstream>
+#include <cstring>
+
+// ? Strongest first, the first one listed for a source is used
+static const char *const ALGORITHMS[] = { "b2", "sha512", "sha384", "sha256", "sha224" };
+
+
+bool Read_Srcinfo(const std::string &path, Srcinfo &fields)
+{
+    std::ifstream srcinfo_file(path);
+    if (!srcinfo_file) return false;
+
+    std::string line;
+    bool seen_pkgbase = false;
+    while (std::getline(srcinfo_file, line)) {
+        std::size_t start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#') continue;
+
+        std::size_t equals = line.find(" = ", start);
+        if (equals == std::string::npos) continue;
+        std::string key = line.substr(start, equals - start);
+        std::string value = line.substr(equals + 3);
+
+        if (key == "pkgname") break;
+        if (key == "pkgbase") seen_pkgbase = true;
+        fields[key].push_back(value);
+    }
+    return seen_pkgbase;
+}
+
+
+std::vector<Source_Entry> Checksummed_Sources(const Srcinfo &fields)
+{
+    std::vector<Source_Entry> sources;
+    for (const auto &[key, values] : fields) {
+        // ? source and source_<arch> pair with the checksum arrays of the same suffix
+        if (key.compare(0, 6, "source") != 0 || (key.size() > 6 && key[6] != '_')) continue;
+        const std::string suffix = key.substr(6);
+
+        for (std::size_t i = 0; i < values.size(); i++) {
+            Source_Entry entry;
+            entry.url = values[i];
+            std::size_t rename = entry.url.find("::");
+            if (rename != std::string::npos) {
+                entry.file_name = entry.url.substr(0, rename);
+                entry.url = entry.url.substr(rename + 2);
+            }
+
+            // ? VCS sources (git+https://...) and files shipped in the package repository are not cached
+            std::size_t scheme_end = entry.url.find("://");
+            if (scheme_end == std::string::npos) continue;
+            const std::string scheme = entry.url.substr(0, scheme_end);
+            if (scheme != "http" && scheme != "https" && scheme != "ftp") continue;
+            if (entry.file_name.empty()) {
+                entry.file_name = entry.url.substr(entry.url.find_last_of('/') + 1);
+                entry.file_name = entry.file_name.substr(0, entry.file_name.find_first_of("?#"));
+            }
+            if (entry.file_name.empty() || entry.file_name.find('/') != std::string::npos || entry.file_name[0] == '.') continue;
+
+            for (const char *algorithm : ALGORITHMS) {
+                auto checksums = fields.find(std::string(algorithm) + "sums" + suffix);
+                if (checksums == fields.end() || checksums->second.size() <= i) continue;
+                const std::string &checksum = checksums->second[i];
+                if (checksum.empty() || checksum.find_first_not_of("0123456789abcdef") != std::string::npos) continue;
+                entry.algorithm = algorithm;
+                entry.checksum = checksum;
+                break;
+            }
+            if (!entry.checksum.empty()) sources.push_back(std::move(entry));
+        }
+    }
+    return sources;
+}
+
+
+bool Has_Unpinned_Sources(const Srcinfo &fields)
+{
+    static const char *const VCS_SCHEMES[] = { "git", "svn", "hg", "bzr", "fossil" };
+
+    for (const auto &[key, values] : fields) {
+        // ? Any checksum array can hold SKIP, md5sums included
+        if (key.find("sums") != std::string::npos) {
+            for (const auto &checksum : values) {
+                if (checksum == "SKIP") return true;
+            }
+            continue;
+        }
+        if (key.compare(0, 6, "source") != 0 || (key.size() > 6 && key[6] != '_')) continue;
+
+        for (const auto &value : values) {
+            std::size_t rename = value.find("::");
+            std::string location = rename == std::string::npos ? value : value.substr(rename + 2);
+            std::size_t scheme_end = location.find("://");
+            if (scheme_end == std::string::npos) continue;
+
+            // ? git+https://, or a bare git:// and friends
+            std::string scheme = location.substr(0, scheme_end);
+            scheme = scheme.substr(0, scheme.find('+'));
+            for (const char *vcs_scheme : VCS_SCHEMES) {
+                if (scheme == vcs_scheme) return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+std::vector<std::string> Build_Dependencies(const Srcinfo &fields)
+{
+    std::vector<std::string> dependencies;
+    for (const auto &[key, values] : fields) {
+        for (const char *prefix : { "depends", "makedepends", "checkdepends" }) {
+            const std::size_t length = std::strlen(prefix);
+            if (key.compare(0, length, prefix) != 0 || (key.size() > length && key[length] != '_')) continue;
+            dependencies.insert(dependencies.end(), values.begin(), values.end());
+        }
+    }
+    return dependencies;
+}
+
+
+std::vector<std::string> Local_Files(const Srcinfo &fields)
+{
+    std::vector<std::string> files;
+    for (const auto &[key, values] : fields) {
+        if (key == "install" || key == "changelog") files.insert(files.end(), values.begin(), values.end());
+        if (key.compare(0, 6, "source") != 0 || (key.size() > 6 && key[6] != '_')) continue;
+
+        for (const auto &value : values) {
+            std::size_t rename = value.find("::");
+            std::string location = rename == std::string::npos ? value : value.substr(rename + 2);
+            if (location.find("://") == std::string::npos) files.push_back(location);
+        }
+    }
+    return files;
+}
@@ -0,0 +1,106 @@
+#include "../include/substituter.hpp"
+#include "../include/source_cache.hpp"
+#include "../include/command.hpp"
+#include "../include/colours.hpp"
+#include "../include/rpc_client.hpp"
+#include "../include/sha256.hpp"
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <unistd.h>
+#include <memory>
+#include <thread>
+
+
+static bool Is_Remote(const std::string &source)
+{
+    return source.compare(0, 7, "http://") == 0 || source.compare(0, 8, "https://") == 0;
+}
+
+
+// ? Copies source/relative_path to target, over HTTP or from a directory
+static bool Get_File(RPC_Client *client, const std::string &source, const std::string &relative_path, const std::string &target)
+{
+    if (!client) return Link_File(source + "/" + relative_path, target);
+
+    std::ofstream file(target, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    bool success = false;
+    client->Queue(source + "/" + relative_path,
+        [&file](const char *data, std::size_t size) {
+            file.write(data, static_cast<std::streamsize>(size));
+            return file.good();
+        },
+        [&success](bool done, long) { success = done; });
+    client->Perform();
+    file.close();
+    return success && file.good();
+}
+
+
+Substituter::Substituter(const std::vector<std::string> &sources, const Artifact_Cache &artifact_cache)
+    : sources(sources), artifact_cache(artifact_cache)
+{
+}
+
+
+bool Substituter::Fetch_From(const std::string &source, const std::string &input_hash, const std::string &version, const std::string &tmp_path)
+{
+    // ? Runs on build workers, each lookup keeps its own connections
+    std::unique_ptr<RPC_Client> client;
+    if (Is_Remote(source)) client = std::make_unique<RPC_Client>(source, 2);
+
+    const std::string manifest_path = tmp_path + "/MANIFEST";
+    if (!Get_File(client.get(), source, input_hash + "/MANIFEST", manifest_path)) return false;
+
+    std::ifstream manifest(manifest_path);
+    std::string line;
+    if (!std::getline(manifest, line) || line != "version " + version) return false;
+
+    std::vector<std::string> pkg_files;
+    while (std::getline(manifest, line)) {
+        std::istringstream fields(line);
+        std::string checksum;
+        std::string file_name;
+        if (!(fields >> checksum >> file_name) || checksum.size() != 64 || file_name.find('/') != std::string::npos
+            || file_name.find(".pkg.tar") == std::string::npos) return false;
+
+        const std::string pkg_file = tmp_path + "/" + file_name;
+        if (!Get_File(client.get(), source, input_hash + "/" + file_name, pkg_file) || SHA256_File(pkg_file) != checksum) return false;
+
+        // ? The package gets installed as root, so it has to be signed by a key pacman trusts
+        const std::string sig_file = pkg_file + ".sig";
+        if (!Get_File(client.get(), source, input_hash + "/" + file_name + ".sig", sig_file)
+            || Run_Command({ "pacman-key", "--verify", sig_file, pkg_file }, "", "/dev/null")) {
+            std::cerr << WARNING_COLOUR << "Rejecting substitute " << file_name << " from " << source << ", its signature did not verify\n" << RESET;
+            return false;
+        }
+        pkg_files.push_back(pkg_file);
+    }
+    return !pkg_files.empty() && artifact_cache.Store(input_hash, version, pkg_files);
+}
+
+
+bool Substituter::Fetch(const std::string &input_hash, const std::string &version, std::vector<std::string> &pkg_files)
+{
+    std::ostringstream thread_id;
+    thread_id << std::this_thread::get_id();
+    const std::string tmp_path = artifact_cache.Directory() + input_hash + ".download" + std::to_string(getpid()) + "-" + thread_id.str();
+
+    for (const auto &source : sources) {
+        std::error_code error;
+        std::filesystem::remove_all(tmp_path, error);
+        std::filesystem::create_directories(tmp_path, error);
+        if (error) break;
+
+        const bool found = Fetch_From(source.compare(0, 7, "file://") == 0 ? source.substr(7) : source, input_hash, version, tmp_path);
+        std::filesystem::remove_all(tmp_path, error);
+        if (found && artifact_cache.Find(input_hash, pkg_files)) {
+            hits++;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,50 @@
+#include "../include/colours.hpp"
+#include "../include/local_db.hpp"
+#include "../include/sync_db.hpp"
+#include <archive_entry.h>
+#include <archive.h>
+#include <iostream>
+
+
+Sync_DB::Sync_DB(const std::string &db_path)
+    : db_path(!db_path.empty() && db_path.back() != '/' ? db_path + '/' : db_path)
+{
+}
+
+
+bool Sync_DB::Load()
+{
+    if (loaded) return true;
+
+    std::string desc;
+    for (const auto &sync_db : Sync_DBs(db_path)) {
+        archive *db = archive_read_new();
+        archive_read_support_filter_all(db);
+        archive_read_support_format_all(db);
+
+        if (archive_read_open_filename(db, sync_db.c_str(), 65536) != ARCHIVE_OK) {
+            std::cerr << WARNING_COLOUR << "Failed to open " << sync_db << ": " << archive_error_string(db) << '\n' << RESET;
+            archive_read_free(db);
+            return false;
+        }
+
+        archive_entry *entry;
+        while (archive_read_next_header(db, &entry) == ARCHIVE_OK) {
+            std::string_view path = archive_entry_pathname(entry);
+            if (path.size() < 5 || path.substr(path.size() - 5) != "/desc") continue;
+
+            desc.clear();
+            char buffer[8192];
+            la_ssize_t read_size;
+            while ((read_size = archive_read_data(db, buffer, sizeof(buffer))) > 0) desc.append(buffer, read_size);
+
+            std::string_view name = Desc_Field(desc, "%NAME%");
+            if (name.empty()) continue;
+            provides.Add(std::string(name), std::string(Desc_Field(desc, "%VERSION%")), Desc_List(desc, "%PROVIDES%"));
+        }
+        archive_read_free(db);
+    }
+
+    loaded = true;
+    return true;
+}
@@ -0,0 +1,220 @@
+#include "../include/tar_stream.hpp"
+#include <archive.h>
+#include <archive_entry.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+
+static const std::size_t BLOCK_SIZE = 512;
+
+
+// ? Tar numbers are octal text, or base-256 when the leading bit is set
+static std::uint64_t Parse_Number(const char *field, std::size_t length)
+{
+    std::uint64_t value = 0;
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        value = static_cast<unsigned char>(field[0]) & 0x7f;
+        for (std::size_t i = 1; i < length; i++) value = (value << 8) | static_cast<unsigned char>(field[i]);
+        return value;
+    }
+
+    for (std::size_t i = 0; i < length && field[i]; i++) {
+        if (field[i] == ' ') continue;
+        if (field[i] < '0' || field[i] > '7') break;
+        value = (value << 3) | static_cast<std::uint64_t>(field[i] - '0');
+    }
+    return value;
+}
+
+
+static std::string Field(const char *field, std::size_t length)
+{
+    return std::string(field, strnlen(field, length));
+}
+
+
+// ? Records are "<length> <key>=<value>\n"
+static void Parse_Pax(const std::string &data, std::string &path, std::string &link)
+{
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        std::size_t space = data.find(' ', pos);
+        if (space == std::string::npos) return;
+        std::size_t length = std::strtoull(data.c_str() + pos, nullptr, 10);
+        if (length == 0 || pos + length > data.size()) return;
+
+        std::string record = data.substr(space + 1, pos + length - space - 2);
+        std::size_t equals = record.find('=');
+        if (equals != std::string::npos) {
+            std::string key = record.substr(0, equals);
+            if (key == "path") path = record.substr(equals + 1);
+            else if (key == "linkpath") link = record.substr(equals + 1);
+        }
+        pos += length;
+    }
+}
+
+
+Tar_Stream::Tar_Stream(const std::string &dest_dir, std::size_t strip_components)
+    : dest_dir(dest_dir), strip_components(strip_components), gzip([this](const char *data, std::size_t size) { return Feed_Tar(data, size); })
+{
+    disk = archive_write_disk_new();
+    archive_write_disk_set_options(disk, ARCHIVE_EXTRACT_PERM | ARCHIVE_EXTRACT_TIME
+        | ARCHIVE_EXTRACT_SECURE_NODOTDOT | ARCHIVE_EXTRACT_SECURE_SYMLINKS);
+    archive_write_disk_set_standard_lookup(disk);
+}
+
+
+Tar_Stream::~Tar_Stream()
+{
+    if (disk) archive_write_free(disk);
+}
+
+
+bool Tar_Stream::Fail(const std::string &message)
+{
+    if (error.empty()) error = message;
+    return false;
+}
+
+
+bool Tar_Stream::Feed(const char *data, std::size_t size)
+{
+    if (!error.empty()) return false;
+    if (!disk) return Fail("Failed to set up the extractor");
+
+    // ? Tar errors are already recorded by Feed_Tar(), anything else came from the gzip layer
+    if (!gzip.Feed(data, size)) return Fail("Corrupt gzip stream");
+    return true;
+}
+
+
+bool Tar_Stream::Feed_Tar(const char *data, std::size_t size)
+{
+    while (size > 0) {
+        switch (state) {
+        case State::END:
+            // ? Whatever follows the end marker is zero padding
+            return true;
+
+        case State::HEADER: {
+            std::size_t take = std::min(size, BLOCK_SIZE - header.size());
+            header.append(data, take);
+            data += take;
+            size -= take;
+            if (header.size() < BLOCK_SIZE) break;
+
+            if (std::all_of(header.begin(), header.end(), [](char c) { return c == 0; })) {
+                state = State::END;
+                header.clear();
+                break;
+            }
+            if (!Start_Entry()) return false;
+            header.clear();
+            break;
+        }
+
+        case State::DATA: {
+            std::size_t take = static_cast<std::size_t>(std::min<std::uint64_t>(size, remaining));
+            if (entry_open) {
+                if (archive_write_data(disk, data, take) < 0) return Fail(archive_error_string(disk));
+            } else if (entry_type == 'x' || entry_type == 'L' || entry_type == 'K') entry_data.append(data, take);
+            data += take;
+            size -= take;
+            remaining -= take;
+            if (remaining == 0 && !Finish_Entry()) return false;
+            break;
+        }
+
+        case State::PADDING: {
+            std::size_t take = static_cast<std::size_t>(std::min<std::uint64_t>(size, padding));
+            data += take;
+            size -= take;
+            padding -= take;
+            if (padding == 0) state = State::HEADER;
+            break;
+        }
+        }
+    }
+    return true;
+}
+
+
+bool Tar_Stream::Start_Entry()
+{
+    const char *block = header.data();
+    std::uint64_t checksum = Parse_Number(block + 148, 8);
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < BLOCK_SIZE; i++) sum += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(block[i]);
+    if (sum != checksum) return Fail("Corrupt tar header");
+
+    entry_type = block[156];
+    remaining = Parse_Number(block + 124, 12);
+    padding = (BLOCK_SIZE - remaining % BLOCK_SIZE) % BLOCK_SIZE;
+    entry_data.clear();
+    entry_open = false;
+
+    std::string path = next_path;
+    std::string link = next_link;
+    if (entry_type != 'x' && entry_type != 'g' && entry_type != 'L' && entry_type != 'K') {
+        if (path.empty()) {
+            path = Field(block, 100);
+            std::string prefix = Field(block + 345, 155);
+            if (std::memcmp(block + 257, "ustar", 5) == 0 && !prefix.empty()) path = prefix + "/" + path;
+        }
+        if (link.empty()) link = Field(block + 157, 100);
+        next_path.clear();
+        next_link.clear();
+
+        // ? Drop the leading directories, the entries that are nothing but those are skipped
+        std::size_t start = 0;
+        for (std::size_t i = 0; i < strip_components && start != std::string::npos; i++) {
+            start = path.find('/', start);
+            if (start != std::string::npos) start++;
+        }
+        std::string relative = start == std::string::npos ? "" : path.substr(start);
+        while (!relative.empty() && relative.back() == '/') relative.pop_back();
+        if (!relative.empty() && relative[0] == '/') return Fail("Absolute path in archive: " + path);
+
+        mode_t file_type = 0;
+        if (entry_type == '0' || entry_type == '\0' || entry_type == '7') file_type = AE_IFREG;
+        else if (entry_type == '5') file_type = AE_IFDIR;
+        else if (entry_type == '2') file_type = AE_IFLNK;
+
+        // ? Hard links, devices and fifos have no place in a package's sources
+        if (!relative.empty() && file_type) {
+            archive_entry *entry = archive_entry_new();
+            archive_entry_set_pathname(entry, (dest_dir + "/" + relative).c_str());
+            archive_entry_set_filetype(entry, file_type);
+            archive_entry_set_perm(entry, static_cast<mode_t>(Parse_Number(block + 100, 8) & 07777));
+            archive_entry_set_mtime(entry, static_cast<time_t>(Parse_Number(block + 136, 12)), 0);
+            if (file_type == AE_IFREG) archive_entry_set_size(entry, static_cast<la_int64_t>(remaining));
+            if (file_type == AE_IFLNK) archive_entry_set_symlink(entry, link.c_str());
+
+            int ret = archive_write_header(disk, entry);
+            archive_entry_free(entry);
+            if (ret < ARCHIVE_WARN) return Fail(archive_error_string(disk));
+            entry_open = true;
+        }
+    }
+
+    state = State::DATA;
+    return remaining > 0 || Finish_Entry();
+}
+
+
+bool Tar_Stream::Finish_Entry()
+{
+    if (entry_open) {
+        entry_open = false;
+        if (archive_write_finish_entry(disk) < ARCHIVE_WARN) return Fail(archive_error_string(disk));
+    }
+
+    if (entry_type == 'x') Parse_Pax(entry_data, next_path, next_link);
+    else if (entry_type == 'L') next_path = entry_data.c_str();
+    else if (entry_type == 'K') next_link = entry_data.c_str();
+    entry_data.clear();
+
+    state = padding > 0 ? State::PADDING : State::HEADER;
+    return true;
+}
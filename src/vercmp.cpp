@@ -0,0 +1,109 @@
+#include "../include/vercmp.hpp"
+#include <cctype>
+
+
+static bool Is_Alnum(char c) { return std::isalnum(static_cast<unsigned char>(c)); }
+static bool Is_Alpha(char c) { return std::isalpha(static_cast<unsigned char>(c)); }
+static bool Is_Digit(char c) { return std::isdigit(static_cast<unsigned char>(c)); }
+
+
+PKG_Version Parse_Version(std::string_view full)
+{
+    PKG_Version version;
+
+    std::size_t epoch_end = 0;
+    while (epoch_end < full.size() && Is_Digit(full[epoch_end])) epoch_end++;
+
+    // ? Unlike rpm, a missing epoch always means 0
+    std::size_t pkgver_start = 0;
+    version.epoch = "0";
+    if (epoch_end < full.size() && full[epoch_end] == ':') {
+        if (epoch_end > 0) version.epoch = full.substr(0, epoch_end);
+        pkgver_start = epoch_end + 1;
+    }
+
+    std::size_t pkgrel_start = full.rfind('-');
+    if (pkgrel_start != std::string_view::npos && pkgrel_start >= epoch_end) {
+        version.pkgver = full.substr(pkgver_start, pkgrel_start - pkgver_start);
+        version.pkgrel = full.substr(pkgrel_start + 1);
+        version.has_pkgrel = true;
+    } else {
+        version.pkgver = full.substr(pkgver_start);
+    }
+    return version;
+}
+
+
+// ? rpmvercmp(): compares alternating runs of digits and letters, skipping any other characters
+static int32_t Compare_Segments(std::string_view a, std::string_view b)
+{
+    if (a == b) return 0;
+
+    std::size_t one = 0, two = 0;
+    std::size_t end_one = 0, end_two = 0;
+
+    while (one < a.size() && two < b.size()) {
+        while (one < a.size() && !Is_Alnum(a[one])) one++;
+        while (two < b.size() && !Is_Alnum(b[two])) two++;
+
+        if (one >= a.size() || two >= b.size()) break;
+
+        // ? A longer run of separators wins
+        if (one - end_one != two - end_two) return one - end_one < two - end_two ? -1 : 1;
+
+        end_one = one;
+        end_two = two;
+        const bool is_number = Is_Digit(a[end_one]);
+        if (is_number) {
+            while (end_one < a.size() && Is_Digit(a[end_one])) end_one++;
+            while (end_two < b.size() && Is_Digit(b[end_two])) end_two++;
+        } else {
+            while (end_one < a.size() && Is_Alpha(a[end_one])) end_one++;
+            while (end_two < b.size() && Is_Alpha(b[end_two])) end_two++;
+        }
+
+        // ? Different segment types, numbers are always newer than letters
+        if (two == end_two) return is_number ? 1 : -1;
+
+        std::string_view segment_one = a.substr(one, end_one - one);
+        std::string_view segment_two = b.substr(two, end_two - two);
+        if (is_number) {
+            while (!segment_one.empty() && segment_one.front() == '0') segment_one.remove_prefix(1);
+            while (!segment_two.empty() && segment_two.front() == '0') segment_two.remove_prefix(1);
+            if (segment_one.size() != segment_two.size()) return segment_one.size() > segment_two.size() ? 1 : -1;
+        }
+
+        int compared = segment_one.compare(segment_two);
+        if (compared) return compared < 0 ? -1 : 1;
+
+        one = end_one;
+        two = end_two;
+    }
+
+    const bool one_done = one >= a.size();
+    const bool two_done = two >= b.size();
+    if (one_done && two_done) return 0;
+
+    // ? A trailing letter segment never beats an empty one, e.g. 1.0alpha is older than 1.0
+    if ((one_done && !Is_Alpha(b[two])) || (!one_done && Is_Alpha(a[one]))) return -1;
+    return 1;
+}
+
+
+int32_t Compare_Versions(const PKG_Version &a, const PKG_Version &b)
+{
+    int32_t result = Compare_Segments(a.epoch, b.epoch);
+    if (result) return result;
+
+    result = Compare_Segments(a.pkgver, b.pkgver);
+    if (result || !a.has_pkgrel || !b.has_pkgrel) return result;
+
+    return Compare_Segments(a.pkgrel, b.pkgrel);
+}
+
+
+int32_t Vercmp(std::string_view a, std::string_view b)
+{
+    if (a == b) return 0;
+    return Compare_Versions(Parse_Version(a), Parse_Version(b));
+}
@@ -0,0 +1,124 @@
+#include "../include/vercmp.hpp"
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+
+
+// * Conformance table from pacman's test/util/vercmptest.sh, so Vercmp() stays pinned to rpmvercmp,
+// * followed by a microbenchmark of the comparison Check_For_Updates() runs per foreign package.
+
+struct Vercmp_Case {
+    const char *a;
+    const char *b;
+    int32_t expected;
+};
+
+static const Vercmp_Case CASES[] = {
+    // ? All similar length, no pkgrel
+    { "1.5.0", "1.5.0", 0 },
+    { "1.5.1", "1.5.0", 1 },
+    // ? Mixed length
+    { "1.5.1", "1.5", 1 },
+    // ? With pkgrel, simple
+    { "1.5.0-1", "1.5.0-1", 0 },
+    { "1.5.0-1", "1.5.0-2", -1 },
+    { "1.5.0-1", "1.5.1-1", -1 },
+    { "1.5.0-2", "1.5.1-1", -1 },
+    // ? With pkgrel, mixed lengths
+    { "1.5-1", "1.5.1-1", -1 },
+    { "1.5-2", "1.5.1-1", -1 },
+    { "1.5-2", "1.5.1-2", -1 },
+    // ? Mixed pkgrel inclusion
+    { "1.5", "1.5-1", 0 },
+    { "1.5-1", "1.5", 0 },
+    { "1.1-1", "1.1", 0 },
+    { "1.0-1", "1.1", -1 },
+    { "1.1-1", "1.0", 1 },
+    // ? Alphanumeric versions
+    { "1.5b-1", "1.5-1", -1 },
+    { "1.5b", "1.5", -1 },
+    { "1.5b-1", "1.5", -1 },
+    { "1.5b", "1.5.1", -1 },
+    // ? From the manpage
+    { "1.0a", "1.0alpha", -1 },
+    { "1.0alpha", "1.0b", -1 },
+    { "1.0b", "1.0beta", -1 },
+    { "1.0beta", "1.0rc", -1 },
+    { "1.0rc", "1.0", -1 },
+    // ? Alpha-dotted versions
+    { "1.5.a", "1.5", 1 },
+    { "1.5.b", "1.5.a", 1 },
+    { "1.5.1", "1.5.b", 1 },
+    // ? Alpha dots and dashes
+    { "1.5.b-1", "1.5.b", 0 },
+    { "1.5-1", "1.5.b", -1 },
+    // ? Same or similar content, differing separators
+    { "2.0", "2_0", 0 },
+    { "2.0_a", "2_0.a", 0 },
+    { "2.0a", "2.0.a", -1 },
+    { "2___a", "2_a", 1 },
+    // ? Epoch included version comparisons
+    { "0:1.0", "0:1.0", 0 },
+    { "0:1.0", "0:1.1", -1 },
+    { "1:1.0", "0:1.0", 1 },
+    { "1:1.0", "0:1.1", 1 },
+    { "1:1.0", "2:1.1", -1 },
+    // ? Epoch and sometimes present pkgrel
+    { "1:1.0", "0:1.0-1", 1 },
+    { "1:1.0-1", "0:1.1-1", 1 },
+    // ? Epoch included on one version
+    { "0:1.0", "1.0", 0 },
+    { "0:1.1", "1.0", 1 },
+    { "0:1.1", "1.1", 0 },
+    { "1:1.0", "1.0", 1 },
+    { "1:1.1", "1.0", 1 },
+    { "1:1.1", "1.1", 1 },
+};
+
+
+static int32_t Sign(int32_t value)
+{
+    return (value > 0) - (value < 0);
+}
+
+
+int32_t main()
+{
+    std::size_t failures = 0;
+    for (const auto &test_case : CASES) {
+        // ? Like vercmptest.sh, every case is also checked the other way around
+        const int32_t forward = Sign(Vercmp(test_case.a, test_case.b));
+        const int32_t backward = Sign(Vercmp(test_case.b, test_case.a));
+        if (forward == test_case.expected && backward == -test_case.expected) continue;
+
+        std::cerr << "FAIL: " << test_case.a << " vs " << test_case.b << ": expected " << test_case.expected
+                  << ", got " << forward << " (reversed " << backward << ")\n";
+        failures++;
+    }
+    const std::size_t case_count = sizeof(CASES) / sizeof(CASES[0]);
+    std::cout << case_count - failures << '/' << case_count << " vercmp cases passed\n";
+
+    // ? Parsed once like in Check_For_Updates(), then compared pairwise
+    std::vector<std::string> versions;
+    for (const auto &test_case : CASES) {
+        versions.push_back(test_case.a);
+        versions.push_back(test_case.b);
+    }
+    std::vector<PKG_Version> parsed;
+    for (const auto &version : versions) parsed.push_back(Parse_Version(version));
+
+    const std::size_t ROUNDS = 2000;
+    int64_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < ROUNDS; round++) {
+        for (const auto &a : parsed) {
+            for (const auto &b : parsed) checksum += Compare_Versions(a, b);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double comparisons = static_cast<double>(ROUNDS * parsed.size() * parsed.size());
+    std::cout << "Compare_Versions: " << seconds * 1e9 / comparisons << " ns per comparison (checksum " << checksum << ")\n";
+
+    return failures ? 1 : 0;
+}